@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <functional>
@@ -6,401 +7,320 @@
 #include <map>
 #include <numeric>
 #include <queue>
+#include <span>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
-#include <atomic>
-#include <execution>
-#include <mutex>
-
-using vertex_type = int;
-using distance_type = unsigned int;
-
-struct VertexDistancePair {
-    vertex_type vertex_index;
-    distance_type distance;
-};
-
-template<>
-struct std::greater<VertexDistancePair> {
-    bool operator()(const VertexDistancePair &lhs, const VertexDistancePair &rhs) const {
-        return lhs.distance > rhs.distance;
-    }
-};
-
-struct DistancesAndFurthestVertex {
-    std::vector<distance_type> all_pairs_shortest_paths;
-    std::vector<VertexDistancePair> furthest_reaching_vertex;
-};
+#include "apsp.h"
+#include "batch_pipeline.h"
+#include "distance_matrix_file.h"
+#include "graph.h"
+#include "graph_io.h"
+#include "incremental_apsp.h"
+#include "shortest_path_trees.h"
 
 /**
- * @brief Reads the connectivity in the specified path. The file format must be:
- *      number_vertices : size_t
- *      (source_index : size_t, target_index : size_t, weight : unsigned int)*
- *      and no index must be larger or equal to the number of vertices
- * @param path The path to the file that specifies the connectivity
- * @return The connectivity as an adjacency list, i.e.,
- *      for vertices i, j, and the weight of their edge k,
- *      <return>[i][j] = k
- *      if <return>[i] does not contain j, then k == 0
+ * @param variant The name the stages of the variant are recorded under, see perf_counters.h
  */
-std::vector<std::map<vertex_type, distance_type>> read_connectivity(const std::filesystem::path &path) {
-    std::ifstream file(path);
-    std::string line{};
-
-    std::getline(file, line);
-
-    std::stringstream sstream_number_vertices(line);
+template<typename Graph>
+void measure_execution_time(const std::string &variant, const Graph &connectivity,
+                            std::function<DistancesAndFurthestVertex(const std::type_identity_t<Graph> &)> function) {
+    const PerfVariantScope variant_scope(variant);
 
-    vertex_type number_vertices = 0;
-    sstream_number_vertices >> number_vertices;
-
-    std::vector<std::map<vertex_type, distance_type>> connectivity(number_vertices);
-
-    while (std::getline(file, line)) {
-        std::stringstream sstream_connectivity(line);
+    const auto before_calculation = std::chrono::high_resolution_clock::now();
+    const auto&[distances, furthest_points] = function(connectivity);
+    const auto after_calculation = std::chrono::high_resolution_clock::now();
 
-        vertex_type source_idx = 0;
-        vertex_type target_idx = 0;
-        distance_type weight = 0;
+    std::map<distance_type, vertex_type> histogram{};
 
-        const auto success =
-                (sstream_connectivity >> source_idx) &&
-                (sstream_connectivity >> target_idx) &&
-                (sstream_connectivity >> weight);
+    for (const auto&[vertex_index, distance]: furthest_points) {
+        histogram[distance]++;
+    }
 
-        if (!success) {
-            continue;
-        }
+    const auto time = (after_calculation - before_calculation).count();
 
-        if (source_idx >= number_vertices || target_idx >= number_vertices) {
-            continue;
-        }
+    std::cout << "The calculation took: " << time << " ns.\n";
 
-        connectivity[source_idx][target_idx] += weight;
+    for (const auto&[distance, number_vertices]: histogram) {
+        std::cout << "There are " << number_vertices << " vertices that have a largest smallest-path to them of: " << distance << '\n';
     }
-
-    return connectivity;
 }
 
 /**
- * @brief Calculated the shortest paths from the specified source vertex using the connectivity
- * @param connectivity The adjacency list of the graph
- * @param source_vertex_id The index of the source vertex from which the shortest path to all vertices should be calculated
- * @return The shortest paths, i.e.,
- *		for all vertices i, the shortest path source_vertex_id--->i has the distance k,
- *		<return>[i] = k
+ * @brief The batch mode, which runs do_work_parallel_tiled over many graphs with loading and writing overlapped,
+ *		see batch_pipeline.h:
+ *      04_exercise_apsp --batch [--depth <n>] [--output-directory <directory>] [--list <file>] <graph>...
+ *		--list reads one graph path per line. With --output-directory, every distance matrix is written to
+ *		<directory>/<graph file stem>.apsp, graphs with the same stem are rejected before anything is calculated,
+ *		otherwise only a summary line per graph is printed
  */
-std::vector<distance_type>
-dijkstra_shortest_paths(const std::vector<std::map<vertex_type, distance_type>> &connectivity, vertex_type source_vertex_id) {
-    const auto number_vertices = connectivity.size();
-    std::vector<distance_type> distances(number_vertices, std::numeric_limits<distance_type>::max());
-
-    std::priority_queue<VertexDistancePair, std::vector<VertexDistancePair>, std::greater<VertexDistancePair>> shortest_paths_queue{};
-
-    distances[source_vertex_id] = 0;
-    shortest_paths_queue.emplace(source_vertex_id, 0);
+int run_batch(int argc, char **argv) {
+    std::size_t depth = 2;
+    std::filesystem::path output_directory{};
+    std::vector<std::filesystem::path> graph_paths{};
 
-    while (!shortest_paths_queue.empty()) {
-        const auto current_distance = shortest_paths_queue.top().distance;
-        const auto current_vertex_id = shortest_paths_queue.top().vertex_index;
+    for (int argument_id = 2; argument_id < argc; argument_id++) {
+        const std::string argument = argv[argument_id];
 
-        shortest_paths_queue.pop();
-
-        for (const auto&[vertex_id, edge_weight]: connectivity[current_vertex_id]) {
-            const auto new_distance = current_distance + edge_weight;
-            if (new_distance < distances[vertex_id]) {
-                distances[vertex_id] = new_distance;
-                shortest_paths_queue.emplace(vertex_id, new_distance);
+        if (argument.starts_with("--")) {
+            if (argument_id + 1 >= argc) {
+                throw std::invalid_argument(argument + " needs a value");
+            }
+            const std::string value = argv[++argument_id];
+
+            if (argument == "--depth") {
+                depth = std::max<std::size_t>(std::stoul(value), 1);
+            } else if (argument == "--output-directory") {
+                output_directory = value;
+            } else if (argument == "--list") {
+                std::ifstream list(value);
+                if (!list) {
+                    throw std::runtime_error("cannot open " + value);
+                }
+                for (std::string line; std::getline(list, line);) {
+                    if (!line.empty()) {
+                        graph_paths.emplace_back(line);
+                    }
+                }
+            } else {
+                throw std::invalid_argument("unknown option " + argument);
             }
+        } else {
+            graph_paths.emplace_back(argument);
         }
     }
 
-    return distances;
-}
-
-/**
- * @brief Calculates the all-pairs shortest-paths algorithm for the given adjacency list
- * @param connectivity The adjacency list for the graph
- * @return For all pairs for vertices i, j, the shortest path between them, i.e.,
- *		<return>[i * number_vertices + j] = k
- *		indicates that the shortest path i--->j has distance k
- */
-std::vector<distance_type> all_pairs_shortest_paths(const std::vector<std::map<vertex_type, distance_type>> &connectivity) {
-    const auto number_vertices = connectivity.size();
-
-    std::vector<distance_type> all_distances(number_vertices * number_vertices, std::numeric_limits<distance_type>::max());
-    for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
-        const auto &local_distances = dijkstra_shortest_paths(connectivity, source_vertex_id);
-        const auto offset = source_vertex_id * number_vertices;
-
-        for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
-            const auto current_distance = local_distances[target_vertex_id];
-            all_distances[offset + target_vertex_id] = current_distance;
-        }
+    if (graph_paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --batch [--depth <n>] [--output-directory <directory>] [--list <file>] <graph>...\n";
+        return 1;
     }
 
-    return all_distances;
-}
-
-std::vector<distance_type> all_pairs_shortest_paths_parallel(const std::vector<std::map<vertex_type, distance_type>> &connectivity) {
-    const auto number_vertices = connectivity.size();
-
-    std::vector<vertex_type> indices(number_vertices);
-    std::iota(indices.begin(), indices.end(), vertex_type(0));
-
-    std::vector<distance_type> all_distances(number_vertices * number_vertices, std::numeric_limits<distance_type>::max());
+    // <directory>/<stem>.apsp of two graphs with the same stem, e.g. a/graph.txt and b/graph.txt, would overwrite each other
+    const auto matrix_path = [&output_directory, &graph_paths](std::size_t file_id) {
+        auto path = output_directory / graph_paths[file_id].stem();
+        path += ".apsp";
+        return path;
+    };
+
+    if (!output_directory.empty()) {
+        std::map<std::filesystem::path, std::size_t> output_files{};
+        for (std::size_t file_id = 0; file_id < graph_paths.size(); file_id++) {
+            const auto [existing, inserted] = output_files.emplace(matrix_path(file_id), file_id);
+            if (!inserted) {
+                throw std::invalid_argument(graph_paths[existing->second].string() + " and " + graph_paths[file_id].string() +
+                                            " would both be written to " + existing->first.string());
+            }
+        }
 
-    std::for_each(std::execution::par, indices.begin(), indices.end(),
-                  [&all_distances, &connectivity, number_vertices](vertex_type source_vertex_id) {
-                      const auto &local_distances = dijkstra_shortest_paths(connectivity, source_vertex_id);
-                      const auto offset = source_vertex_id * number_vertices;
+        std::filesystem::create_directories(output_directory);
+    }
 
-                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
-                          const auto current_distance = local_distances[target_vertex_id];
-                          all_distances[offset + target_vertex_id] = current_distance;
-                      }
-                  }
-    );
+    const auto statistics = run_batch_pipeline(
+            std::span<const std::filesystem::path>(graph_paths), depth,
+            [](const std::filesystem::path &graph_path) {
+                return load_graph(graph_path);
+            },
+            [](CsrGraph &&connectivity) {
+                return do_work_parallel_tiled(connectivity);
+            },
+            [&](std::size_t file_id, const DistancesAndFurthestVertex &result) {
+                const auto &[distances, furthest_points] = result;
+
+                if (!output_directory.empty()) {
+                    write_distance_matrix(matrix_path(file_id), distances, furthest_points);
+                }
+
+                const auto furthest = std::max_element(furthest_points.begin(), furthest_points.end(),
+                                                       [](const VertexDistancePair &lhs, const VertexDistancePair &rhs) {
+                                                           return lhs.distance < rhs.distance;
+                                                       });
+                std::cout << graph_paths[file_id].string() << ": " << furthest_points.size()
+                          << " vertices, the largest smallest-path is "
+                          << (furthest == furthest_points.end() ? distance_type(0) : furthest->distance) << '\n';
+            });
+
+    std::cout << "The batch of " << statistics.number_graphs << " graphs with depth " << depth << " took: "
+              << statistics.total_seconds << " s, loading " << statistics.load_seconds << " s, calculating "
+              << statistics.compute_seconds << " s and writing " << statistics.write_seconds << " s.\n" << std::flush;
 
-    return all_distances;
+    return 0;
 }
 
-/**
- * @brief Calculates for each vertex, the largest smallest-path from another vertex to the first one
- * @param all_distance The all-pairs shortest-paths distance matrix
- * @param number_vertices The number of vertices
- * @return <return>[i] = (j, k) indicates that
- *		from all shortest paths to i, j has the longest, and its distance is k
- */
-std::vector<VertexDistancePair>
-calculate_largest_smallest_path(const std::vector<distance_type> &all_distance, vertex_type number_vertices) {
-    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
-
-    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
-        furthest_reaching_vertex[vertex_id] = {vertex_id, 0};
-    }
+int main(int argc, char **argv) {
+    // before any thread is started, so all of them inherit the counters
+    open_perf_counters();
 
-    for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
-        const auto offset = source_vertex_id * number_vertices;
-
-        for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
-            const auto current_distance = all_distance[offset + target_vertex_id];
-
-            const auto current_furthest_distance = furthest_reaching_vertex[target_vertex_id].distance;
-            if (current_distance > current_furthest_distance) {
-                furthest_reaching_vertex[target_vertex_id] = {source_vertex_id, current_distance};
-            }
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        try {
+            return run_batch(argc, argv);
+        } catch (const std::exception &exception) {
+            std::cerr << exception.what() << '\n';
+            return 1;
         }
     }
 
-    return furthest_reaching_vertex;
-}
-
-std::vector<VertexDistancePair>
-calculate_largest_smallest_path_parallel_lock(const std::vector<distance_type> &all_distance, vertex_type number_vertices) {
-    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
-
-    std::vector<vertex_type> indices(number_vertices);
-    std::iota(indices.begin(), indices.end(), vertex_type(0));
-
-    std::for_each(std::execution::par, indices.begin(), indices.end(), [&furthest_reaching_vertex](vertex_type vertex_id) {
-        furthest_reaching_vertex[vertex_id] = {vertex_id, 0};
-    });
-
-    std::vector<std::mutex> mutexes(number_vertices);
+    std::vector<std::map<vertex_type, distance_type>> manual_connectivity =
+            {
+                    {{1, 3}, {2, 8}},
+                    {{0, 2}, {2, 1}},
+                    {{0, 2}, {1, 3}}
+            };
 
-    std::for_each(std::execution::par, indices.begin(), indices.end(),
-                  [number_vertices, &furthest_reaching_vertex, &all_distance, &mutexes](vertex_type source_vertex_id) {
-                      const auto offset = source_vertex_id * number_vertices;
+    const std::filesystem::path graph_path = argc > 1 ? argv[1] : "./graph.txt";
 
-                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
-                          const auto current_distance = all_distance[offset + target_vertex_id];
+    ParseStatistics parse_statistics{};
 
-                          std::lock_guard<std::mutex> lock(mutexes[target_vertex_id]);
+    const auto before_loading = std::chrono::high_resolution_clock::now();
+    const CsrGraph file_csr_connectivity = [&graph_path, &parse_statistics] {
+        const PerfVariantScope variant_scope("graph");
+        return load_graph(graph_path, &parse_statistics);
+    }();
+    const auto after_loading = std::chrono::high_resolution_clock::now();
 
-                          const auto current_furthest_distance = furthest_reaching_vertex[target_vertex_id].distance;
-                          if (current_distance > current_furthest_distance) {
-                              furthest_reaching_vertex[target_vertex_id] = {source_vertex_id, current_distance};
-                          }
-                      }
-                  }
-    );
+    std::cout << "Loading " << graph_path.string() << " took: " << (after_loading - before_loading).count() << " ns.\n";
+    if (parse_statistics.number_bytes > 0) {
+        std::cout << "Parsed " << parse_statistics.number_bytes << " bytes with " << parse_statistics.number_threads
+                  << " threads at " << parse_statistics.megabytes_per_second() << " MB/s.\n";
+    }
 
-    return furthest_reaching_vertex;
-}
+    const auto file_connectivity = make_adjacency_list(file_csr_connectivity);
+
+    std::cout << "Per-source loops run on the " << parallel_backend_name() << " backend with "
+              << parallel_number_threads() << " threads.\n";
+
+    std::cout << "Adjacency list of maps:\n";
+    measure_execution_time("serial/map", file_connectivity, do_work_serial<adjacency_list_type>);
+    measure_execution_time("parallel_lock/map", file_connectivity, do_work_parallel_lock<adjacency_list_type>);
+    measure_execution_time("parallel_atomic/map", file_connectivity, do_work_parallel_atomic<adjacency_list_type>);
+    measure_execution_time("parallel_atomic_ref/map", file_connectivity, do_work_parallel_atomic_ref<adjacency_list_type>);
+    measure_execution_time("parallel_packed/map", file_connectivity, do_work_parallel_packed<adjacency_list_type>);
+    measure_execution_time("parallel_tiled/map", file_connectivity, do_work_parallel_tiled<adjacency_list_type>);
+
+    std::cout << "Compressed sparse row graph"
+              << (has_uniform_weights(file_csr_connectivity) ? " (uniform weights, direction-optimizing BFS)" : "") << ":\n";
+    measure_execution_time("serial/csr", file_csr_connectivity, do_work_serial<CsrGraph>);
+    measure_execution_time("parallel_lock/csr", file_csr_connectivity, do_work_parallel_lock<CsrGraph>);
+    measure_execution_time("parallel_atomic/csr", file_csr_connectivity, do_work_parallel_atomic<CsrGraph>);
+    measure_execution_time("parallel_atomic_ref/csr", file_csr_connectivity, do_work_parallel_atomic_ref<CsrGraph>);
+    measure_execution_time("parallel_packed/csr", file_csr_connectivity, do_work_parallel_packed<CsrGraph>);
+    measure_execution_time("parallel_tiled/csr", file_csr_connectivity, do_work_parallel_tiled<CsrGraph>);
+    measure_execution_time("multi_source_bfs/csr", file_csr_connectivity, do_work_multi_source_bfs);
+    measure_execution_time("numa/csr", file_csr_connectivity, do_work_numa);
+
+    for (const auto ordering: {VertexOrdering::reverse_cuthill_mckee, VertexOrdering::degree_descending, VertexOrdering::bfs}) {
+        std::cout << "Relabeled in " << vertex_ordering_name(ordering) << " order (average edge span "
+                  << average_edge_span(reorder_graph(file_csr_connectivity, ordering).graph) << " instead of "
+                  << average_edge_span(file_csr_connectivity) << "):\n";
+        const auto variant = std::string("reordered_") + vertex_ordering_name(ordering) + "/csr";
+        measure_execution_time(variant, file_csr_connectivity, [ordering](const CsrGraph &connectivity) {
+            return do_work_reordered(connectivity, ordering);
+        });
+    }
 
-std::vector<VertexDistancePair>
-calculate_largest_smallest_path_parallel_atomic_ref(const std::vector<distance_type> &all_distance, vertex_type number_vertices) {
-    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
+    const auto narrowest_types = select_narrowest_types(file_csr_connectivity);
+    std::cout << "Narrowest types (" << narrowest_types.vertex_bytes << "-byte vertices, " << narrowest_types.distance_bytes
+              << "-byte distances for paths up to " << maximum_path_length(file_csr_connectivity) << "):\n";
+    measure_execution_time("narrowest/csr", file_csr_connectivity, do_work_narrowest);
 
-    std::vector<vertex_type> indices(number_vertices);
-    std::iota(indices.begin(), indices.end(), vertex_type(0));
+    std::cout << "Streaming reductions without the distance matrix:\n";
+    measure_execution_time("streaming/csr", file_csr_connectivity, do_work_streaming<CsrGraph>);
 
-    std::for_each(std::execution::par, indices.begin(), indices.end(), [&furthest_reaching_vertex](vertex_type vertex_id) {
-        furthest_reaching_vertex[vertex_id] = {vertex_id, 0};
+    std::cout << "Out-of-core with a 1 MiB budget for the tiles:\n";
+    measure_execution_time("out_of_core/csr", file_csr_connectivity, [](const CsrGraph &connectivity) {
+        return do_work_out_of_core(connectivity, 1 << 20);
     });
 
-    std::for_each(std::execution::par, indices.begin(), indices.end(),
-                  [number_vertices, &furthest_reaching_vertex, &all_distance](vertex_type source_vertex_id) {
-                      const auto offset = source_vertex_id * number_vertices;
-
-                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
-                          const auto current_distance = all_distance[offset + target_vertex_id];
-                          const VertexDistancePair proposed = {source_vertex_id, current_distance};
-
-                          std::atomic_ref<VertexDistancePair> atomic_view(furthest_reaching_vertex[target_vertex_id]);
-
-                          auto value = proposed;
-                          auto previous_value = atomic_view.exchange(value, std::memory_order::relaxed);
-
-                          while (previous_value.distance > value.distance) {
-                              value = previous_value;
-                              previous_value = atomic_view.exchange(value, std::memory_order::relaxed);
-                          }
-                      }
-                  }
-    );
-
-    return furthest_reaching_vertex;
-}
-
-std::vector<VertexDistancePair>
-calculate_largest_smallest_path_parallel_atomic(const std::vector<distance_type> &all_distance, vertex_type number_vertices) {
-    std::vector<std::atomic<VertexDistancePair>> furthest_reaching_vertex_atomic(number_vertices);
-
-    std::vector<vertex_type> indices(number_vertices);
-    std::iota(indices.begin(), indices.end(), vertex_type(0));
-
-    std::for_each(std::execution::par, indices.begin(), indices.end(),
-                  [&furthest_reaching_vertex_atomic](vertex_type vertex_id) {
-                      furthest_reaching_vertex_atomic[vertex_id] = {vertex_id, 0};
-                  }
-    );
-
-    std::for_each(std::execution::par, indices.begin(), indices.end(),
-                  [number_vertices, &furthest_reaching_vertex_atomic, &all_distance](vertex_type source_vertex_id) {
-                      const auto offset = source_vertex_id * number_vertices;
-
-                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
-                          const auto current_distance = all_distance[offset + target_vertex_id];
-                          VertexDistancePair proposed = {source_vertex_id, current_distance};
-
-                          auto value = proposed;
-                          auto previous_value = furthest_reaching_vertex_atomic[target_vertex_id].exchange(value,
-                                                                                                           std::memory_order::relaxed);
-                          while (previous_value.distance > value.distance) {
-                              value = previous_value;
-                              previous_value = furthest_reaching_vertex_atomic[target_vertex_id].exchange(value,
-                                                                                                          std::memory_order::relaxed);
-                          }
-                      }
-                  }
-    );
-
-    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
-
-    std::for_each(std::execution::par, indices.begin(), indices.end(),
-                  [&furthest_reaching_vertex_atomic, &furthest_reaching_vertex](vertex_type vertex_id) {
-                      furthest_reaching_vertex[vertex_id] = furthest_reaching_vertex_atomic[vertex_id].load();
-                  });
-
-    return furthest_reaching_vertex;
-}
-
-/**
- * @brief Calculated all pairs shortest paths by repeatedly applying Dijkstra's algorithm,
- *		and also which nodes have the largest shortest-path to each other node
- * @param connectivity The adjacency list of the graph
- * @return
- *		(1)	The shortest paths between all vertices, i.e.,
- *			for vertices i, j, the shortest path i--->j has the distance k,
- *			<return.all_pairs_shortest_paths>[i * offset + j] = k
- *			where offset is the number of vertices in the graph
- *		(2) The index and distance of the node, that has the
- *			longest shortest-distance to the other node, i.e.,
- *			<return.furthest_reaching_vertex>[i] = (j, w)
- *			expresses that the shortest path j--->i has distance w
- *			and for all other vertices k != j with shortest path k--->i with distance w'
- *			w' < w
- */
-DistancesAndFurthestVertex do_work_serial(const std::vector<std::map<vertex_type, distance_type>> &connectivity) {
-    const auto number_vertices = connectivity.size();
-
-    const auto &all_distances = all_pairs_shortest_paths(connectivity);
-    const auto &furthest_reaching_vertices = calculate_largest_smallest_path(all_distances, number_vertices);
-
-    return {all_distances, furthest_reaching_vertices};
-}
-
-DistancesAndFurthestVertex do_work_parallel_lock(const std::vector<std::map<vertex_type, distance_type>> &connectivity) {
-    const auto number_vertices = connectivity.size();
-
-    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
-    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_lock(all_distances, number_vertices);
-
-    return {all_distances, furthest_reaching_vertices};
-}
-
-DistancesAndFurthestVertex do_work_parallel_atomic(const std::vector<std::map<vertex_type, distance_type>> &connectivity) {
-    const auto number_vertices = connectivity.size();
-
-    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
-    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_atomic(all_distances, number_vertices);
-
-    return {all_distances, furthest_reaching_vertices};
-}
-
-DistancesAndFurthestVertex do_work_parallel_atomic_ref(const std::vector<std::map<vertex_type, distance_type>> &connectivity) {
-    const auto number_vertices = connectivity.size();
-
-    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
-    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_atomic_ref(all_distances, number_vertices);
-
-    return {all_distances, furthest_reaching_vertices};
-}
+    const auto &[eccentricity_reducer, closeness_reducer, histogram_reducer] =
+            stream_all_pairs_shortest_paths<EccentricityReducer, ClosenessReducer, DistanceHistogramReducer>(file_csr_connectivity);
+    const auto &[radius, diameter] = std::minmax_element(eccentricity_reducer.eccentricity.begin(),
+                                                          eccentricity_reducer.eccentricity.end());
 
+    std::cout << "The radius is " << *radius << " and the diameter is " << *diameter << ".\n";
+    std::cout << "Vertex 0 has a closeness of " << closeness_reducer.closeness(0) << ".\n";
+    for (const auto&[distance, number_pairs]: histogram_reducer.histogram) {
+        std::cout << "There are " << number_pairs << " pairs of vertices with a shortest path of: " << distance << '\n';
+    }
 
-void measure_execution_time(const std::vector<std::map<vertex_type, distance_type>> &connectivity,
-                            std::function<DistancesAndFurthestVertex(const std::vector<std::map<vertex_type, distance_type>> &)> function) {
+    std::cout << "Bounded eccentricities without the distance matrix:\n";
+    measure_execution_time("bounded_eccentricity/csr", file_csr_connectivity, do_work_bounded_eccentricity);
 
-    const auto before_calculation = std::chrono::high_resolution_clock::now();
-    const auto&[distances, furthest_points] = function(connectivity);
-    const auto after_calculation = std::chrono::high_resolution_clock::now();
+    std::size_t number_searches = 0;
+    calculate_largest_smallest_path_bounded(file_csr_connectivity, &number_searches);
+    const auto sampled_bounds = sample_largest_smallest_path(file_csr_connectivity, 16);
+    std::cout << "The exact bounds needed " << number_searches << " searches instead of " << file_csr_connectivity.size()
+              << ", 16 sampled vertices leave " << sampled_bounds.number_open() << " vertices open with a relative error of at most "
+              << sampled_bounds.maximum_relative_error() << ".\n";
 
-    std::map<distance_type, vertex_type> histogram{};
+    std::cout << "Incremental updates:\n";
+    auto updated_connectivity = file_connectivity;
+    auto [updated_distances, updated_furthest_reaching_vertex] = do_work_serial(updated_connectivity);
 
-    for (const auto&[vertex_index, distance]: furthest_points) {
-        histogram[distance]++;
+    const auto number_vertices = static_cast<vertex_type>(updated_connectivity.size());
+    std::vector<Edge> new_edges{};
+    for (vertex_type edge_id = 1; edge_id <= 8 && number_vertices > 0; edge_id++) {
+        new_edges.push_back({(edge_id * 97) % number_vertices, (edge_id * 389) % number_vertices, file_csr_connectivity.minimum_weight});
     }
 
-    const auto time = (after_calculation - before_calculation).count();
-
-    std::cout << "The calculation took: " << time << " ns.\n";
-
-    for (const auto&[distance, number_vertices]: histogram) {
-        std::cout << "There are " << number_vertices << " vertices that have a largest smallest-path to them of: " << distance << '\n';
+    const auto before_update = std::chrono::high_resolution_clock::now();
+    const auto update_statistics = update_all_pairs_shortest_paths(updated_connectivity, updated_distances,
+                                                                   updated_furthest_reaching_vertex, new_edges);
+    const auto after_update = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Inserting " << new_edges.size() << " edges took: " << (after_update - before_update).count() << " ns, "
+              << update_statistics.number_affected_sources << " sources and " << update_statistics.number_affected_targets
+              << " targets were affected.\n";
+
+    const auto before_recalculation = std::chrono::high_resolution_clock::now();
+    const auto recalculated = do_work_serial(updated_connectivity);
+    const auto after_recalculation = std::chrono::high_resolution_clock::now();
+
+    const auto identical = recalculated.all_pairs_shortest_paths == updated_distances &&
+                           std::equal(recalculated.furthest_reaching_vertex.begin(), recalculated.furthest_reaching_vertex.end(),
+                                      updated_furthest_reaching_vertex.begin(), updated_furthest_reaching_vertex.end(),
+                                      [](const VertexDistancePair &lhs, const VertexDistancePair &rhs) {
+                                          return lhs.vertex_index == rhs.vertex_index && lhs.distance == rhs.distance;
+                                      });
+    std::cout << "Recalculating took: " << (after_recalculation - before_recalculation).count() << " ns, the results are "
+              << (identical ? "identical" : "different") << ".\n";
+
+    std::cout << "Shortest-path trees:\n";
+    const auto before_trees = std::chrono::high_resolution_clock::now();
+    const auto &[tree_distances, shortest_path_trees] = all_pairs_shortest_paths_with_trees(file_csr_connectivity);
+    const auto after_trees = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Calculating the distances and the trees took: " << (after_trees - before_trees).count() << " ns, the trees take "
+              << shortest_path_trees.size_bytes() << " bytes.\n";
+
+    if (number_vertices > 0) {
+        const auto furthest = calculate_largest_smallest_path(tree_distances, number_vertices)[0];
+        std::vector<vertex_type> path_buffer(number_vertices);
+        const auto path = shortest_path_trees.path(furthest.vertex_index, 0, path_buffer);
+
+        std::cout << "The shortest path " << furthest.vertex_index << "--->0 has distance " << furthest.distance << ":";
+        for (const auto vertex_id: path) {
+            std::cout << ' ' << vertex_id;
+        }
+        std::cout << '\n';
     }
-}
 
+    std::cout << "Blocked Floyd-Warshall:\n";
+    measure_execution_time("floyd_warshall/csr", file_csr_connectivity, do_work_floyd_warshall<CsrGraph>);
 
-int main() {
-    std::vector<std::map<vertex_type, distance_type>> manual_connectivity =
-            {
-                    {{1, 3}, {2, 8}},
-                    {{0, 2}, {2, 1}},
-                    {{0, 2}, {1, 3}}
-            };
+    if (argc > 2) {
+        const std::filesystem::path matrix_path = argv[2];
 
-    std::vector<std::map<vertex_type, distance_type>> file_connectivity =
-            read_connectivity("./graph.txt");
+        const auto before_saving = std::chrono::high_resolution_clock::now();
+        const auto result = do_work_parallel_tiled(file_csr_connectivity);
+        write_distance_matrix(matrix_path, result.all_pairs_shortest_paths, result.furthest_reaching_vertex);
+        const auto after_saving = std::chrono::high_resolution_clock::now();
 
-    measure_execution_time(file_connectivity, do_work_serial);
-    measure_execution_time(file_connectivity, do_work_parallel_lock);
-    measure_execution_time(file_connectivity, do_work_parallel_atomic);
-    measure_execution_time(file_connectivity, do_work_parallel_atomic_ref);
+        std::cout << "Calculating and saving the distance matrix to " << matrix_path.string() << " took: "
+                  << (after_saving - before_saving).count() << " ns.\n";
+    }
 
+    print_perf_counter_report(std::cout);
     std::cout << std::flush;
 
     return 0;
@@ -0,0 +1,646 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <execution>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "bfs.h"
+#include "dijkstra.h"
+#include "eccentricity_bounds.h"
+#include "execution_backend.h"
+#include "floyd_warshall.h"
+#include "graph.h"
+#include "multi_source_bfs.h"
+#include "narrow_types.h"
+#include "numa_apsp.h"
+#include "out_of_core_apsp.h"
+#include "perf_counters.h"
+#include "streaming_apsp.h"
+#include "vertex_ordering.h"
+
+#include "../06_exercise/atomic_extrema.h"
+
+struct DistancesAndFurthestVertex {
+    std::vector<distance_type> all_pairs_shortest_paths;
+    std::vector<VertexDistancePair> furthest_reaching_vertex;
+};
+
+/**
+ * @brief Calculates the all-pairs shortest-paths algorithm for the given adjacency list
+ *		If all edges of a CSR graph have the same weight, a direction-optimizing BFS replaces Dijkstra
+ * @tparam Queue The priority queue policy of Dijkstra, see priority_queues.h
+ * @param connectivity The adjacency list for the graph
+ * @return For all pairs for vertices i, j, the shortest path between them as the distance type of the graph, i.e.,
+ *		<return>[i * number_vertices + j] = k
+ *		indicates that the shortest path i--->j has distance k
+ */
+template<typename Queue = BinaryHeapQueue, typename Graph>
+std::vector<graph_distance_t<Graph>> all_pairs_shortest_paths(const Graph &connectivity) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+    if constexpr (is_csr_graph_v<Graph>) {
+        if (has_uniform_weights(connectivity)) {
+            return all_pairs_shortest_paths_bfs(connectivity);
+        }
+    }
+
+    const auto number_vertices = connectivity.size();
+
+    using Distance = graph_distance_t<Graph>;
+    std::vector<Distance> all_distances(number_vertices * number_vertices, std::numeric_limits<Distance>::max());
+    for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+        const auto offset = source_vertex_id * number_vertices;
+        dijkstra_shortest_paths<Queue>(connectivity, source_vertex_id,
+                                       std::span<Distance>(all_distances.data() + offset, number_vertices));
+    }
+
+    return all_distances;
+}
+
+template<typename Queue = BinaryHeapQueue, typename Graph>
+std::vector<graph_distance_t<Graph>> all_pairs_shortest_paths_parallel(const Graph &connectivity) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+    if constexpr (is_csr_graph_v<Graph>) {
+        if (has_uniform_weights(connectivity)) {
+            return all_pairs_shortest_paths_bfs_parallel(connectivity);
+        }
+    }
+
+    const auto number_vertices = connectivity.size();
+    const auto sources = order_sources_by_cost(connectivity);
+
+    using Distance = graph_distance_t<Graph>;
+    std::vector<Distance> all_distances(number_vertices * number_vertices, std::numeric_limits<Distance>::max());
+
+    parallel_for_each_source(sources,
+                             [&all_distances, &connectivity, number_vertices](vertex_type source_vertex_id) {
+                                 const auto offset = source_vertex_id * number_vertices;
+                                 dijkstra_shortest_paths<Queue>(connectivity, source_vertex_id,
+                                                                std::span<Distance>(all_distances.data() + offset, number_vertices));
+                             }
+    );
+
+    return all_distances;
+}
+
+/**
+ * @brief Calculates for each vertex, the largest smallest-path from another vertex to the first one
+ * @param all_distance The all-pairs shortest-paths distance matrix
+ * @param number_vertices The number of vertices
+ * @tparam Distance The distance type of the matrix, its maximum marks unreachable vertices
+ * @return <return>[i] = (j, k) indicates that
+ *		from all shortest paths to i, j has the longest, and its distance is k
+ */
+template<typename Distance>
+std::vector<VertexDistancePair>
+calculate_largest_smallest_path(std::span<const Distance> all_distance, vertex_type number_vertices) {
+    const PerfStageScope stage_scope(PerfStage::reduction);
+    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
+
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        furthest_reaching_vertex[vertex_id] = {vertex_id, 0};
+    }
+
+    for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+        const auto offset = source_vertex_id * number_vertices;
+
+        for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
+            const auto current_distance = all_distance[offset + target_vertex_id];
+
+            const auto current_furthest_distance = furthest_reaching_vertex[target_vertex_id].distance;
+            if (widen_distance(current_distance) > current_furthest_distance) {
+                furthest_reaching_vertex[target_vertex_id] = {source_vertex_id, widen_distance(current_distance)};
+            }
+        }
+    }
+
+    return furthest_reaching_vertex;
+}
+
+inline std::vector<VertexDistancePair>
+calculate_largest_smallest_path(std::span<const distance_type> all_distance, vertex_type number_vertices) {
+    return calculate_largest_smallest_path<distance_type>(all_distance, number_vertices);
+}
+
+inline std::vector<VertexDistancePair>
+calculate_largest_smallest_path_parallel_lock(std::span<const distance_type> all_distance, vertex_type number_vertices) {
+    const PerfStageScope stage_scope(PerfStage::reduction);
+    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
+
+    std::vector<vertex_type> indices(number_vertices);
+    std::iota(indices.begin(), indices.end(), vertex_type(0));
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&furthest_reaching_vertex](vertex_type vertex_id) {
+        furthest_reaching_vertex[vertex_id] = {vertex_id, 0};
+    });
+
+    std::vector<std::mutex> mutexes(number_vertices);
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [number_vertices, &furthest_reaching_vertex, &all_distance, &mutexes](vertex_type source_vertex_id) {
+                      const auto offset = source_vertex_id * number_vertices;
+
+                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
+                          const auto current_distance = all_distance[offset + target_vertex_id];
+
+                          std::lock_guard<std::mutex> lock(mutexes[target_vertex_id]);
+
+                          const auto current_furthest_distance = furthest_reaching_vertex[target_vertex_id].distance;
+                          if (current_distance > current_furthest_distance) {
+                              furthest_reaching_vertex[target_vertex_id] = {source_vertex_id, current_distance};
+                          }
+                      }
+                  }
+    );
+
+    return furthest_reaching_vertex;
+}
+
+inline std::vector<VertexDistancePair>
+calculate_largest_smallest_path_parallel_atomic_ref(std::span<const distance_type> all_distance, vertex_type number_vertices) {
+    const PerfStageScope stage_scope(PerfStage::reduction);
+    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
+
+    std::vector<vertex_type> indices(number_vertices);
+    std::iota(indices.begin(), indices.end(), vertex_type(0));
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&furthest_reaching_vertex](vertex_type vertex_id) {
+        furthest_reaching_vertex[vertex_id] = {vertex_id, 0};
+    });
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [number_vertices, &furthest_reaching_vertex, &all_distance](vertex_type source_vertex_id) {
+                      const auto offset = source_vertex_id * number_vertices;
+
+                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
+                          const auto current_distance = all_distance[offset + target_vertex_id];
+                          const VertexDistancePair proposed = {source_vertex_id, current_distance};
+
+                          std::atomic_ref<VertexDistancePair> atomic_view(furthest_reaching_vertex[target_vertex_id]);
+
+                          auto value = proposed;
+                          auto previous_value = atomic_view.exchange(value, std::memory_order::relaxed);
+
+                          while (previous_value.distance > value.distance) {
+                              value = previous_value;
+                              previous_value = atomic_view.exchange(value, std::memory_order::relaxed);
+                          }
+                      }
+                  }
+    );
+
+    return furthest_reaching_vertex;
+}
+
+inline std::vector<VertexDistancePair>
+calculate_largest_smallest_path_parallel_atomic(std::span<const distance_type> all_distance, vertex_type number_vertices) {
+    const PerfStageScope stage_scope(PerfStage::reduction);
+    std::vector<std::atomic<VertexDistancePair>> furthest_reaching_vertex_atomic(number_vertices);
+
+    std::vector<vertex_type> indices(number_vertices);
+    std::iota(indices.begin(), indices.end(), vertex_type(0));
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [&furthest_reaching_vertex_atomic](vertex_type vertex_id) {
+                      furthest_reaching_vertex_atomic[vertex_id] = {vertex_id, 0};
+                  }
+    );
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [number_vertices, &furthest_reaching_vertex_atomic, &all_distance](vertex_type source_vertex_id) {
+                      const auto offset = source_vertex_id * number_vertices;
+
+                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
+                          const auto current_distance = all_distance[offset + target_vertex_id];
+                          VertexDistancePair proposed = {source_vertex_id, current_distance};
+
+                          auto value = proposed;
+                          auto previous_value = furthest_reaching_vertex_atomic[target_vertex_id].exchange(value,
+                                                                                                           std::memory_order::relaxed);
+                          while (previous_value.distance > value.distance) {
+                              value = previous_value;
+                              previous_value = furthest_reaching_vertex_atomic[target_vertex_id].exchange(value,
+                                                                                                          std::memory_order::relaxed);
+                          }
+                      }
+                  }
+    );
+
+    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [&furthest_reaching_vertex_atomic, &furthest_reaching_vertex](vertex_type vertex_id) {
+                      furthest_reaching_vertex[vertex_id] = furthest_reaching_vertex_atomic[vertex_id].load();
+                  });
+
+    return furthest_reaching_vertex;
+}
+
+/**
+ * @brief Same result as calculate_largest_smallest_path, but every column is a packed (distance, vertex) word
+ *		updated with atomic_fetch_argmax, i.e., one lock-free fetch_max that returns early when the row cannot win.
+ *		The packing breaks ties by the smaller source, so the result does not depend on the scheduling
+ */
+inline std::vector<VertexDistancePair>
+calculate_largest_smallest_path_parallel_packed(std::span<const distance_type> all_distance, vertex_type number_vertices) {
+    const PerfStageScope stage_scope(PerfStage::reduction);
+    std::vector<std::atomic<std::uint64_t>> furthest_reaching_vertex_packed(number_vertices);
+
+    std::vector<vertex_type> indices(number_vertices);
+    std::iota(indices.begin(), indices.end(), vertex_type(0));
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [&furthest_reaching_vertex_packed](vertex_type vertex_id) {
+                      furthest_reaching_vertex_packed[vertex_id] = pack_distance_vertex(0, vertex_id);
+                  }
+    );
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [number_vertices, &furthest_reaching_vertex_packed, &all_distance](vertex_type source_vertex_id) {
+                      const auto offset = source_vertex_id * number_vertices;
+
+                      for (vertex_type target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
+                          const auto current_distance = all_distance[offset + target_vertex_id];
+
+                          // like the serial version, a vertex keeps itself unless another vertex is further away
+                          if (current_distance > 0) {
+                              atomic_fetch_argmax(&furthest_reaching_vertex_packed[target_vertex_id], current_distance,
+                                                  source_vertex_id, std::memory_order::relaxed);
+                          }
+                      }
+                  }
+    );
+
+    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
+
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+                  [&furthest_reaching_vertex_packed, &furthest_reaching_vertex](vertex_type vertex_id) {
+                      const auto packed = furthest_reaching_vertex_packed[vertex_id].load(std::memory_order::relaxed);
+                      furthest_reaching_vertex[vertex_id] = {static_cast<vertex_type>(packed_vertex(packed)),
+                                                             packed_distance(packed)};
+                  });
+
+    return furthest_reaching_vertex;
+}
+
+/**
+ * @brief Updates the running argmax of the columns [0, number_columns) of a tile with one row,
+ *		strictly larger distances win, so the first (smallest) source keeps ties
+ * @param furthest_distances The largest distance per column so far
+ * @param furthest_vertices The source of the largest distance per column so far
+ * @param row The distances of the row, restricted to the columns of the tile
+ */
+template<typename Distance>
+void update_column_argmax_scalar(Distance *furthest_distances, vertex_type *furthest_vertices,
+                                 const Distance *row, std::size_t number_columns, vertex_type source_vertex_id) {
+    for (std::size_t column_id = 0; column_id < number_columns; column_id++) {
+        if (row[column_id] > furthest_distances[column_id]) {
+            furthest_distances[column_id] = row[column_id];
+            furthest_vertices[column_id] = source_vertex_id;
+        }
+    }
+}
+
+#ifdef APSP_HAS_X86_SIMD
+
+static_assert(sizeof(vertex_type) == 4, "the AVX2 argmax blends 8 32-bit vertex lanes");
+
+__attribute__((target("avx2")))
+inline void update_column_argmax_avx2(distance_type *furthest_distances, vertex_type *furthest_vertices,
+                                      const distance_type *row, std::size_t number_columns, vertex_type source_vertex_id) {
+    constexpr std::size_t lanes = 8;
+
+    const auto source_vector = _mm256_set1_epi32(source_vertex_id);
+    std::size_t column_id = 0;
+
+    for (; column_id + lanes <= number_columns; column_id += lanes) {
+        const auto row_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + column_id));
+        const auto distance_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(furthest_distances + column_id));
+        const auto vertex_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(furthest_vertices + column_id));
+
+        // there is no unsigned greater-than, the maximum differs from the old distance iff the row is larger
+        const auto maximum = _mm256_max_epu32(row_vector, distance_vector);
+        const auto not_larger = _mm256_cmpeq_epi32(maximum, distance_vector);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(furthest_distances + column_id), maximum);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(furthest_vertices + column_id),
+                            _mm256_blendv_epi8(source_vector, vertex_vector, not_larger));
+    }
+
+    update_column_argmax_scalar(furthest_distances + column_id, furthest_vertices + column_id, row + column_id,
+                                number_columns - column_id, source_vertex_id);
+}
+
+/**
+ * @brief The AVX2 argmax of 8- and 16-bit distances, see narrow_types.h. A vector holds 32 or 16 distances but only 8
+ *		vertices, so the vertices are only blended when the row is larger somewhere, which is rare after the first rows
+ */
+template<typename Distance>
+__attribute__((target("avx2")))
+void update_column_argmax_narrow_avx2(Distance *furthest_distances, vertex_type *furthest_vertices,
+                                      const Distance *row, std::size_t number_columns, vertex_type source_vertex_id) {
+    static_assert(sizeof(Distance) == 1 || sizeof(Distance) == 2);
+    constexpr std::size_t lanes = 32 / sizeof(Distance);
+    constexpr std::size_t vertex_lanes = 8;
+
+    const auto source_vector = _mm256_set1_epi32(source_vertex_id);
+    std::size_t column_id = 0;
+
+    for (; column_id + lanes <= number_columns; column_id += lanes) {
+        const auto row_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + column_id));
+        const auto distance_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(furthest_distances + column_id));
+
+        __m256i maximum;
+        __m256i not_larger;
+        if constexpr (sizeof(Distance) == 1) {
+            maximum = _mm256_max_epu8(row_vector, distance_vector);
+            not_larger = _mm256_cmpeq_epi8(maximum, distance_vector);
+        } else {
+            maximum = _mm256_max_epu16(row_vector, distance_vector);
+            not_larger = _mm256_cmpeq_epi16(maximum, distance_vector);
+        }
+
+        if (_mm256_movemask_epi8(not_larger) == -1) {
+            continue;
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(furthest_distances + column_id), maximum);
+
+        // widens the mask of every 8 distances to 8 vertex lanes
+        const __m128i halves[2] = {_mm256_castsi256_si128(not_larger), _mm256_extracti128_si256(not_larger, 1)};
+        for (std::size_t vertex_block = 0; vertex_block < lanes / vertex_lanes; vertex_block++) {
+            __m256i vertex_mask;
+            if constexpr (sizeof(Distance) == 1) {
+                const auto half = halves[vertex_block / 2];
+                vertex_mask = _mm256_cvtepi8_epi32(vertex_block % 2 == 0 ? half : _mm_srli_si128(half, 8));
+            } else {
+                vertex_mask = _mm256_cvtepi16_epi32(halves[vertex_block]);
+            }
+
+            auto *vertices = reinterpret_cast<__m256i *>(furthest_vertices + column_id + vertex_block * vertex_lanes);
+            _mm256_storeu_si256(vertices, _mm256_blendv_epi8(source_vector, _mm256_loadu_si256(vertices), vertex_mask));
+        }
+    }
+
+    update_column_argmax_scalar(furthest_distances + column_id, furthest_vertices + column_id, row + column_id,
+                                number_columns - column_id, source_vertex_id);
+}
+
+#endif
+
+template<typename Distance>
+using update_column_argmax_function = void (*)(Distance *, vertex_type *, const Distance *, std::size_t, vertex_type);
+
+/**
+ * @brief Selects the AVX2 argmax if the CPU supports it, otherwise the scalar one
+ */
+template<typename Distance = distance_type>
+update_column_argmax_function<Distance> select_update_column_argmax() {
+#ifdef APSP_HAS_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        if constexpr (std::is_same_v<Distance, distance_type>) {
+            return update_column_argmax_avx2;
+        } else if constexpr (sizeof(Distance) < sizeof(distance_type)) {
+            return update_column_argmax_narrow_avx2<Distance>;
+        }
+    }
+#endif
+    return update_column_argmax_scalar<Distance>;
+}
+
+/**
+ * @brief Same result as calculate_largest_smallest_path, but the matrix is partitioned into tiles of columns
+ *		instead of rows. Every tile is owned by one thread, which scans all rows of it and keeps the argmax in
+ *		tile-local arrays, so there are no locks or atomics, and ties are resolved like in the serial version
+ */
+template<typename Distance>
+std::vector<VertexDistancePair>
+calculate_largest_smallest_path_parallel_tiled(std::span<const Distance> all_distance, vertex_type number_vertices) {
+    const PerfStageScope stage_scope(PerfStage::reduction);
+    // a tile row is contiguous and at most 4 KiB, the argmax of a tile stays in L1,
+    // but small graphs still get a few tiles per thread
+    static constexpr std::size_t maximum_tile_columns = 1024;
+    static constexpr std::size_t minimum_tile_columns = 64;
+
+    const auto number_threads = parallel_number_threads();
+    const auto tile_columns = std::clamp((static_cast<std::size_t>(number_vertices) / (4 * number_threads) + 7) / 8 * 8,
+                                         minimum_tile_columns, maximum_tile_columns);
+    const auto number_tiles = (static_cast<std::size_t>(number_vertices) + tile_columns - 1) / tile_columns;
+
+    std::vector<std::size_t> tile_indices(number_tiles);
+    std::iota(tile_indices.begin(), tile_indices.end(), std::size_t(0));
+
+    std::vector<VertexDistancePair> furthest_reaching_vertex(number_vertices);
+    const auto update_column_argmax = select_update_column_argmax<Distance>();
+
+    parallel_for_each_source(tile_indices, [&all_distance, &furthest_reaching_vertex, number_vertices, tile_columns,
+                                            update_column_argmax](vertex_type tile_id) {
+        const auto first_column_id = static_cast<std::size_t>(tile_id) * tile_columns;
+        const auto number_columns = std::min(tile_columns, static_cast<std::size_t>(number_vertices) - first_column_id);
+
+        std::vector<Distance> furthest_distances(number_columns, 0);
+        std::vector<vertex_type> furthest_vertices(number_columns);
+        std::iota(furthest_vertices.begin(), furthest_vertices.end(), static_cast<vertex_type>(first_column_id));
+
+        for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+            const auto offset = static_cast<std::size_t>(source_vertex_id) * number_vertices + first_column_id;
+            update_column_argmax(furthest_distances.data(), furthest_vertices.data(),
+                                 all_distance.data() + offset, number_columns, source_vertex_id);
+        }
+
+        for (std::size_t column_id = 0; column_id < number_columns; column_id++) {
+            furthest_reaching_vertex[first_column_id + column_id] = {furthest_vertices[column_id],
+                                                                     widen_distance(furthest_distances[column_id])};
+        }
+    });
+
+    return furthest_reaching_vertex;
+}
+
+inline std::vector<VertexDistancePair>
+calculate_largest_smallest_path_parallel_tiled(std::span<const distance_type> all_distance, vertex_type number_vertices) {
+    return calculate_largest_smallest_path_parallel_tiled<distance_type>(all_distance, number_vertices);
+}
+
+/**
+ * @brief Calculated all pairs shortest paths by repeatedly applying Dijkstra's algorithm,
+ *		and also which nodes have the largest shortest-path to each other node
+ * @param connectivity The adjacency list of the graph, either as maps or in CSR layout
+ * @return
+ *		(1)	The shortest paths between all vertices, i.e.,
+ *			for vertices i, j, the shortest path i--->j has the distance k,
+ *			<return.all_pairs_shortest_paths>[i * offset + j] = k
+ *			where offset is the number of vertices in the graph
+ *		(2) The index and distance of the node, that has the
+ *			longest shortest-distance to the other node, i.e.,
+ *			<return.furthest_reaching_vertex>[i] = (j, w)
+ *			expresses that the shortest path j--->i has distance w
+ *			and for all other vertices k != j with shortest path k--->i with distance w'
+ *			w' < w
+ */
+template<typename Graph>
+DistancesAndFurthestVertex do_work_serial(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = all_pairs_shortest_paths(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+template<typename Graph>
+DistancesAndFurthestVertex do_work_parallel_lock(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_lock(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+template<typename Graph>
+DistancesAndFurthestVertex do_work_parallel_atomic(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_atomic(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+template<typename Graph>
+DistancesAndFurthestVertex do_work_parallel_atomic_ref(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_atomic_ref(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+template<typename Graph>
+DistancesAndFurthestVertex do_work_parallel_packed(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_packed(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+template<typename Graph>
+DistancesAndFurthestVertex do_work_parallel_tiled(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = all_pairs_shortest_paths_parallel(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_tiled(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+/**
+ * @brief Same as do_work_serial, but calculates the all-pairs shortest-paths with the blocked Floyd-Warshall algorithm,
+ *		which beats repeated Dijkstra on dense graphs
+ */
+template<typename Graph>
+DistancesAndFurthestVertex do_work_floyd_warshall(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = all_pairs_shortest_paths_floyd_warshall(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+/**
+ * @brief Same as do_work_parallel_atomic, but calculates the all-pairs shortest-paths of graphs with uniform weights
+ *		with the bit-parallel multi-source BFS (256 sources per sweep), other graphs use Dijkstra
+ */
+inline DistancesAndFurthestVertex do_work_multi_source_bfs(const CsrGraph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    const auto &all_distances = has_uniform_weights(connectivity)
+                                ? all_pairs_shortest_paths_multi_source_bfs(connectivity)
+                                : all_pairs_shortest_paths_parallel(connectivity);
+    const auto &furthest_reaching_vertices = calculate_largest_smallest_path_parallel_atomic(all_distances, number_vertices);
+
+    return {all_distances, furthest_reaching_vertices};
+}
+
+/**
+ * @brief Same furthest reaching vertices as do_work_serial, but every shortest-path row is reduced as soon as it is
+ *		calculated, so the all-pairs matrix is never stored and <return.all_pairs_shortest_paths> is empty
+ */
+template<typename Graph>
+DistancesAndFurthestVertex do_work_streaming(const Graph &connectivity) {
+    auto [furthest_reaching_vertex_reducer] = stream_all_pairs_shortest_paths<FurthestReachingVertexReducer>(connectivity);
+
+    return {{}, std::move(furthest_reaching_vertex_reducer.furthest_reaching_vertex)};
+}
+
+/**
+ * @brief Same furthest reaching vertices as do_work_serial, but the matrix is calculated by all_pairs_shortest_paths_numa,
+ *		i.e., with pinned workers that first-touch their own rows. The matrix lives in an uninitialized buffer
+ *		instead of a std::vector, so <return.all_pairs_shortest_paths> is empty
+ */
+inline DistancesAndFurthestVertex do_work_numa(const CsrGraph &connectivity) {
+    const auto matrix = all_pairs_shortest_paths_numa(connectivity, parallel_number_threads());
+
+    return {{}, calculate_largest_smallest_path_parallel_tiled(matrix.distances(), static_cast<vertex_type>(connectivity.size()))};
+}
+
+/**
+ * @brief Same furthest reaching vertices as do_work_serial, but the matrix is spilled to a tile file in the temporary
+ *		directory and reduced from there, see out_of_core_apsp.h. <return.all_pairs_shortest_paths> is empty
+ * @param memory_budget_bytes The memory for the tiles in flight, see write_all_pairs_shortest_paths_tiles
+ */
+template<typename Graph>
+DistancesAndFurthestVertex do_work_out_of_core(const Graph &connectivity, std::size_t memory_budget_bytes) {
+    const auto tile_path = temporary_tile_path();
+    const TemporaryFileRemover tile_remover(tile_path);
+
+    write_all_pairs_shortest_paths_tiles(connectivity, tile_path, memory_budget_bytes);
+    auto [furthest_reaching_vertex_reducer] = reduce_distance_tiles<FurthestReachingVertexReducer>(tile_path);
+
+    return {{}, std::move(furthest_reaching_vertex_reducer.furthest_reaching_vertex)};
+}
+
+/**
+ * @brief Same as do_work_parallel_tiled, but on a copy of the graph relabeled in the given order, see vertex_ordering.h.
+ *		The relabeling is part of the work, and the results are mapped back to the original vertex indices
+ */
+inline DistancesAndFurthestVertex do_work_reordered(const CsrGraph &connectivity, VertexOrdering ordering) {
+    const auto number_vertices = connectivity.size();
+    const auto reordered = reorder_graph(connectivity, ordering);
+
+    const auto &reordered_distances = all_pairs_shortest_paths_parallel(reordered.graph);
+    const auto &reordered_furthest = calculate_largest_smallest_path_parallel_tiled(reordered_distances, number_vertices);
+
+    return {restore_distances(reordered_distances, reordered), restore_furthest_reaching_vertex(reordered_furthest, reordered)};
+}
+
+/**
+ * @brief Same furthest reaching vertices as do_work_serial, but bounded from a few forward and backward searches instead of
+ *		one search per vertex, see eccentricity_bounds.h. No distance matrix is calculated, so <return.all_pairs_shortest_paths> is empty
+ */
+inline DistancesAndFurthestVertex do_work_bounded_eccentricity(const CsrGraph &connectivity) {
+    return {{}, calculate_largest_smallest_path_bounded(connectivity)};
+}
+
+/**
+ * @brief Same furthest reaching vertices as do_work_parallel_tiled, but Dijkstra, the matrix and the reduction run on the
+ *		narrowest vertex and distance types that hold the graph, see narrow_types.h. The matrix is not widened back to
+ *		distance_type, so <return.all_pairs_shortest_paths> is empty
+ */
+inline DistancesAndFurthestVertex do_work_narrowest(const CsrGraph &connectivity) {
+    return visit_narrowest_graph(connectivity, [](const auto &narrow_connectivity) -> DistancesAndFurthestVertex {
+        const auto number_vertices = static_cast<vertex_type>(narrow_connectivity.size());
+        const auto &all_distances = all_pairs_shortest_paths_parallel(narrow_connectivity);
+
+        return {{}, calculate_largest_smallest_path_parallel_tiled(std::span(all_distances), number_vertices)};
+    });
+}
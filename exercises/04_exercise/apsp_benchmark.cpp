@@ -0,0 +1,364 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef APSP_HAS_TBB
+#include <tbb/global_control.h>
+#endif
+
+#include "apsp.h"
+#include "graph.h"
+#include "graph_io.h"
+#include "perf_counters.h"
+
+/*
+ * Benchmarks the do_work_* variants of 04_exercise_apsp:
+ *      04_exercise_apsp_benchmark [graph] [--warmups N] [--repetitions N] [--max-threads N] [--json path] [--csv path]
+ * Every parallel variant runs with 1, 2, 4, ... up to --max-threads threads, which applies to the per-source loops
+ * (see execution_backend.h) and, if TBB is available, to the std::execution::par reductions. Every variant is checked
+ * against do_work_serial before it is timed.
+ * Built with -DAPSP_PERF_COUNTERS=ON, it also prints the hardware counters of every stage of the timed repetitions,
+ * see perf_counters.h, e.g. the LLC misses of the reordered_* variants against parallel_tiled show what the vertex
+ * orderings of vertex_ordering.h save.
+ */
+
+struct BenchmarkOptions {
+    std::filesystem::path graph_path = "./graph.txt";
+    unsigned int warmups = 1;
+    unsigned int repetitions = 5;
+    unsigned int maximum_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::filesystem::path json_path{};
+    std::filesystem::path csv_path{};
+};
+
+struct BenchmarkVariant {
+    std::string name;
+    std::string layout;
+    bool parallel;
+    std::function<DistancesAndFurthestVertex()> function;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::string layout;
+    unsigned int number_threads;
+    double minimum_seconds;
+    double median_seconds;
+    double p95_seconds;
+    double speedup;
+    double efficiency;
+    std::size_t peak_rss_kibibytes;
+    bool correct;
+};
+
+BenchmarkOptions parse_options(int argc, char **argv) {
+    BenchmarkOptions options{};
+
+    for (int argument_id = 1; argument_id < argc; argument_id++) {
+        const std::string argument = argv[argument_id];
+
+        if (argument.starts_with("--")) {
+            if (argument_id + 1 >= argc) {
+                throw std::invalid_argument(argument + " needs a value");
+            }
+            const std::string value = argv[++argument_id];
+
+            if (argument == "--warmups") {
+                options.warmups = static_cast<unsigned int>(std::stoul(value));
+            } else if (argument == "--repetitions") {
+                options.repetitions = std::max(static_cast<unsigned int>(std::stoul(value)), 1u);
+            } else if (argument == "--max-threads") {
+                options.maximum_threads = std::max(static_cast<unsigned int>(std::stoul(value)), 1u);
+            } else if (argument == "--json") {
+                options.json_path = value;
+            } else if (argument == "--csv") {
+                options.csv_path = value;
+            } else {
+                throw std::invalid_argument("unknown option " + argument);
+            }
+        } else {
+            options.graph_path = argument;
+        }
+    }
+
+    return options;
+}
+
+/**
+ * @return The thread counts of the sweep: 1, 2, 4, ... and maximum_threads
+ */
+std::vector<unsigned int> thread_sweep(unsigned int maximum_threads) {
+    std::vector<unsigned int> thread_counts{};
+    for (unsigned int number_threads = 1; number_threads < maximum_threads; number_threads *= 2) {
+        thread_counts.push_back(number_threads);
+    }
+    thread_counts.push_back(maximum_threads);
+    return thread_counts;
+}
+
+/**
+ * @brief Reads a field in kB (e.g. VmHWM, the peak resident set size) from /proc/self/status, 0 if it is not there
+ */
+std::size_t read_process_status_kibibytes(const std::string &field) {
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);) {
+        if (line.starts_with(field + ":")) {
+            return std::stoul(line.substr(field.size() + 1));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Resets the peak resident set size to the current one (Linux 4.0 and newer), so VmHWM covers only what follows
+ */
+void reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+/**
+ * @brief Compares a result with the serial baseline. The variants may pick another vertex with the same distance
+ *      as the furthest reaching one, so only its distance has to match the baseline
+ */
+bool matches_baseline(const DistancesAndFurthestVertex &result, const DistancesAndFurthestVertex &baseline) {
+    const auto number_vertices = baseline.furthest_reaching_vertex.size();
+
+    if (!result.all_pairs_shortest_paths.empty() && result.all_pairs_shortest_paths != baseline.all_pairs_shortest_paths) {
+        return false;
+    }
+    if (result.furthest_reaching_vertex.size() != number_vertices) {
+        return false;
+    }
+
+    for (std::size_t target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
+        const auto &[vertex_index, distance] = result.furthest_reaching_vertex[target_vertex_id];
+
+        if (distance != baseline.furthest_reaching_vertex[target_vertex_id].distance ||
+            vertex_index < 0 || static_cast<std::size_t>(vertex_index) >= number_vertices) {
+            return false;
+        }
+        if (distance > 0 && baseline.all_pairs_shortest_paths[vertex_index * number_vertices + target_vertex_id] != distance) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @return The element at the given quantile of the sorted samples (nearest rank)
+ */
+double quantile(const std::vector<double> &sorted_samples, double q) {
+    const auto rank = static_cast<std::size_t>(q * static_cast<double>(sorted_samples.size()) + 0.999999);
+    return sorted_samples[std::clamp<std::size_t>(rank, 1, sorted_samples.size()) - 1];
+}
+
+BenchmarkResult run_variant(const BenchmarkVariant &variant, unsigned int number_threads, const BenchmarkOptions &options,
+                            const DistancesAndFurthestVertex &baseline) {
+    set_parallel_number_threads(number_threads);
+#ifdef APSP_HAS_TBB
+    tbb::global_control thread_limit(tbb::global_control::max_allowed_parallelism, number_threads);
+#endif
+
+    reset_peak_rss();
+
+    const auto correct = matches_baseline(variant.function(), baseline);
+    for (unsigned int warmup_id = 1; warmup_id < options.warmups; warmup_id++) {
+        variant.function();
+    }
+
+    const PerfVariantScope variant_scope(variant.name + "/" + variant.layout + "/" + std::to_string(number_threads));
+
+    std::vector<double> seconds{};
+    for (unsigned int repetition_id = 0; repetition_id < options.repetitions; repetition_id++) {
+        const auto before = std::chrono::steady_clock::now();
+        const auto result = variant.function();
+        const auto after = std::chrono::steady_clock::now();
+
+        seconds.push_back(std::chrono::duration<double>(after - before).count());
+    }
+    std::sort(seconds.begin(), seconds.end());
+
+    return {variant.name, variant.layout, number_threads, seconds.front(), quantile(seconds, 0.5), quantile(seconds, 0.95),
+            1.0, 1.0, read_process_status_kibibytes("VmHWM"), correct};
+}
+
+/**
+ * @return The text as a JSON string literal, quoted and with quotes, backslashes and control characters escaped
+ */
+std::string json_string(const std::string &text) {
+    std::ostringstream literal;
+    literal << '"';
+    for (const auto character: text) {
+        switch (character) {
+            case '"':
+                literal << "\\\"";
+                break;
+            case '\\':
+                literal << "\\\\";
+                break;
+            case '\n':
+                literal << "\\n";
+                break;
+            case '\r':
+                literal << "\\r";
+                break;
+            case '\t':
+                literal << "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(character) < 0x20) {
+                    literal << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                            << static_cast<int>(character) << std::dec << std::setfill(' ');
+                } else {
+                    literal << character;
+                }
+        }
+    }
+    literal << '"';
+    return literal.str();
+}
+
+void write_json(const std::filesystem::path &path, const std::string &graph_name, const std::vector<BenchmarkResult> &results) {
+    std::ofstream file(path);
+    file << "{\n  \"graph\": " << json_string(graph_name) << ",\n  \"backend\": " << json_string(parallel_backend_name())
+         << ",\n  \"results\": [\n";
+
+    for (std::size_t result_id = 0; result_id < results.size(); result_id++) {
+        const auto &result = results[result_id];
+        file << "    {\"variant\": " << json_string(result.name) << ", \"layout\": " << json_string(result.layout)
+             << ", \"threads\": " << result.number_threads
+             << ", \"min_seconds\": " << result.minimum_seconds << ", \"median_seconds\": " << result.median_seconds
+             << ", \"p95_seconds\": " << result.p95_seconds << ", \"speedup\": " << result.speedup
+             << ", \"efficiency\": " << result.efficiency << ", \"peak_rss_kib\": " << result.peak_rss_kibibytes
+             << ", \"correct\": " << (result.correct ? "true" : "false") << "}"
+             << (result_id + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    file << "  ]\n}\n";
+}
+
+void write_csv(const std::filesystem::path &path, const std::vector<BenchmarkResult> &results) {
+    std::ofstream file(path);
+    file << "variant,layout,threads,min_seconds,median_seconds,p95_seconds,speedup,efficiency,peak_rss_kib,correct\n";
+
+    for (const auto &result: results) {
+        file << result.name << ',' << result.layout << ',' << result.number_threads << ',' << result.minimum_seconds << ','
+             << result.median_seconds << ',' << result.p95_seconds << ',' << result.speedup << ',' << result.efficiency << ','
+             << result.peak_rss_kibibytes << ',' << (result.correct ? "true" : "false") << '\n';
+    }
+}
+
+int main(int argc, char **argv) {
+    try {
+        const auto options = parse_options(argc, argv);
+
+        // before any thread is started, so all of them inherit the counters
+        open_perf_counters();
+
+        const CsrGraph csr_connectivity = [&options] {
+            const PerfVariantScope variant_scope("graph");
+            return load_graph(options.graph_path);
+        }();
+        const auto connectivity = make_adjacency_list(csr_connectivity);
+
+        const std::vector<BenchmarkVariant> variants = {
+                {"serial",           "map", false, [&] { return do_work_serial(connectivity); }},
+                {"parallel_lock",    "map", true,  [&] { return do_work_parallel_lock(connectivity); }},
+                {"parallel_atomic",  "map", true,  [&] { return do_work_parallel_atomic(connectivity); }},
+                {"parallel_atomic_ref", "map", true, [&] { return do_work_parallel_atomic_ref(connectivity); }},
+                {"parallel_packed",  "map", true,  [&] { return do_work_parallel_packed(connectivity); }},
+                {"parallel_tiled",   "map", true,  [&] { return do_work_parallel_tiled(connectivity); }},
+                {"serial",           "csr", false, [&] { return do_work_serial(csr_connectivity); }},
+                {"parallel_lock",    "csr", true,  [&] { return do_work_parallel_lock(csr_connectivity); }},
+                {"parallel_atomic",  "csr", true,  [&] { return do_work_parallel_atomic(csr_connectivity); }},
+                {"parallel_atomic_ref", "csr", true, [&] { return do_work_parallel_atomic_ref(csr_connectivity); }},
+                {"parallel_packed",  "csr", true,  [&] { return do_work_parallel_packed(csr_connectivity); }},
+                {"parallel_tiled",   "csr", true,  [&] { return do_work_parallel_tiled(csr_connectivity); }},
+                {"multi_source_bfs", "csr", true,  [&] { return do_work_multi_source_bfs(csr_connectivity); }},
+                {"streaming",        "csr", true,  [&] { return do_work_streaming(csr_connectivity); }},
+                {"numa",             "csr", true,  [&] { return do_work_numa(csr_connectivity); }},
+                {"out_of_core",      "csr", true,  [&] { return do_work_out_of_core(csr_connectivity, 1 << 20); }},
+                {"floyd_warshall",   "csr", false, [&] { return do_work_floyd_warshall(csr_connectivity); }},
+                {"bounded_ecc",      "csr", true,  [&] { return do_work_bounded_eccentricity(csr_connectivity); }},
+                {"narrowest",        "csr", true,  [&] { return do_work_narrowest(csr_connectivity); }},
+                {"reordered_rcm",    "csr", true,  [&] { return do_work_reordered(csr_connectivity, VertexOrdering::reverse_cuthill_mckee); }},
+                {"reordered_degree", "csr", true,  [&] { return do_work_reordered(csr_connectivity, VertexOrdering::degree_descending); }},
+                {"reordered_bfs",    "csr", true,  [&] { return do_work_reordered(csr_connectivity, VertexOrdering::bfs); }},
+        };
+
+        const auto baseline = do_work_serial(csr_connectivity);
+        const auto thread_counts = thread_sweep(options.maximum_threads);
+
+        std::cout << "Benchmarking " << options.graph_path.string() << " (" << csr_connectivity.size() << " vertices, "
+                  << csr_connectivity.number_edges() << " edges) on the " << parallel_backend_name() << " backend, "
+                  << options.warmups << " warmups and " << options.repetitions << " repetitions.\n";
+        // without hardware counters, the average edge span is the locality measure of the orderings
+        std::cout << "Average edge span:";
+        for (const auto ordering: {VertexOrdering::original, VertexOrdering::reverse_cuthill_mckee,
+                                   VertexOrdering::degree_descending, VertexOrdering::bfs}) {
+            std::cout << ' ' << vertex_ordering_name(ordering) << ' '
+                      << average_edge_span(reorder_graph(csr_connectivity, ordering).graph);
+        }
+        std::cout << '\n';
+
+        std::cout << std::left << std::setw(20) << "variant" << std::setw(8) << "layout" << std::right
+                  << std::setw(8) << "threads" << std::setw(12) << "min [s]" << std::setw(12) << "median [s]"
+                  << std::setw(12) << "p95 [s]" << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+                  << std::setw(16) << "peak RSS [MiB]" << "  result\n";
+
+        std::vector<BenchmarkResult> results{};
+        auto all_correct = true;
+
+        for (const auto &variant: variants) {
+            const auto variant_thread_counts = variant.parallel ? thread_counts : std::vector<unsigned int>{1};
+            double single_thread_median = 0;
+
+            for (const auto number_threads: variant_thread_counts) {
+                auto result = run_variant(variant, number_threads, options, baseline);
+
+                if (number_threads == 1) {
+                    single_thread_median = result.median_seconds;
+                }
+                result.speedup = single_thread_median / result.median_seconds;
+                result.efficiency = result.speedup / number_threads;
+                all_correct = all_correct && result.correct;
+
+                std::cout << std::left << std::setw(20) << result.name << std::setw(8) << result.layout << std::right
+                          << std::setw(8) << result.number_threads << std::fixed << std::setprecision(5)
+                          << std::setw(12) << result.minimum_seconds << std::setw(12) << result.median_seconds
+                          << std::setw(12) << result.p95_seconds << std::setprecision(2) << std::setw(10) << result.speedup
+                          << std::setw(12) << result.efficiency << std::setprecision(1)
+                          << std::setw(16) << result.peak_rss_kibibytes / 1024.0 << "  "
+                          << (result.correct ? "ok" : "WRONG") << '\n' << std::defaultfloat;
+
+                results.push_back(result);
+            }
+        }
+
+        if (!options.json_path.empty()) {
+            write_json(options.json_path, options.graph_path.string(), results);
+        }
+        if (!options.csv_path.empty()) {
+            write_csv(options.csv_path, results);
+        }
+
+        print_perf_counter_report(std::cout);
+
+        return all_correct ? 0 : 2;
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+}
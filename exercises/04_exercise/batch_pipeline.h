@@ -0,0 +1,192 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Runs one job over many graph files as a three-stage pipeline:
+ *      loader thread --BoundedQueue--> compute (calling thread) --BoundedQueue--> writer thread
+ * While graph i is calculated, graph i + 1 (up to i + depth) is loaded and the results of graph i - 1 (down to i - depth)
+ * are written, so a batch takes about as long as its slowest stage instead of the sum of all three. The compute stage runs on
+ * the calling thread, so it keeps the per-source loops of execution_backend.h to itself, the loader and the writer mostly
+ * wait for I/O. The depth bounds the memory: at most depth graphs wait for the compute and depth results for the writer.
+ * The results are written in the order of the files.
+ */
+
+/**
+ * @brief A blocking FIFO queue with a fixed capacity. push blocks while it is full, pop while it is empty.
+ *      After close, push drops its item and pop drains what is left
+ */
+template<typename T>
+class BoundedQueue {
+    std::mutex mutex{};
+    std::condition_variable not_full{};
+    std::condition_variable not_empty{};
+    std::deque<T> items{};
+    std::size_t capacity;
+    bool closed = false;
+
+public:
+    explicit BoundedQueue(std::size_t capacity) :
+            capacity(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("a bounded queue needs a capacity of at least 1");
+        }
+    }
+
+    /**
+     * @return false if the queue was closed and the item was dropped
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return items.size() < capacity || closed; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @return The oldest item, std::nullopt once the queue is closed and empty
+     */
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        auto item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        return item;
+    }
+
+    void close() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+};
+
+struct BatchStatistics {
+    std::size_t number_graphs = 0;
+    // the time every stage was busy, without waiting for the queues
+    double load_seconds = 0;
+    double compute_seconds = 0;
+    double write_seconds = 0;
+    double total_seconds = 0;
+};
+
+/**
+ * @brief Runs load, compute and write over all files, overlapping the stages, see the top of this file.
+ *      If a stage throws, the pipeline stops and the first exception is rethrown once all threads are joined
+ * @param paths The graph files, in the order their results are written
+ * @param depth The capacity of both queues, at least 1
+ * @param load Called as load(path) on the loader thread
+ * @param compute Called as compute(loaded) on the calling thread
+ * @param write Called as write(file index, result) on the writer thread
+ */
+template<typename Load, typename Compute, typename Write>
+BatchStatistics run_batch_pipeline(std::span<const std::filesystem::path> paths, std::size_t depth,
+                                   Load &&load, Compute &&compute, Write &&write) {
+    using Loaded = std::invoke_result_t<Load &, const std::filesystem::path &>;
+    using Result = std::invoke_result_t<Compute &, Loaded &&>;
+    using Clock = std::chrono::steady_clock;
+
+    const auto seconds_since = [](Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    BoundedQueue<std::pair<std::size_t, Loaded>> loaded_queue(depth);
+    BoundedQueue<std::pair<std::size_t, Result>> result_queue(depth);
+
+    std::mutex error_mutex{};
+    std::exception_ptr error{};
+    const auto fail = [&] {
+        {
+            const std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        loaded_queue.close();
+        result_queue.close();
+    };
+
+    BatchStatistics statistics{};
+    const auto start = Clock::now();
+
+    std::thread loader([&] {
+        try {
+            for (std::size_t file_id = 0; file_id < paths.size(); file_id++) {
+                const auto load_start = Clock::now();
+                auto loaded = load(paths[file_id]);
+                statistics.load_seconds += seconds_since(load_start);
+
+                if (!loaded_queue.push({file_id, std::move(loaded)})) {
+                    return;
+                }
+            }
+        } catch (...) {
+            fail();
+        }
+        loaded_queue.close();
+    });
+
+    std::thread writer([&] {
+        try {
+            while (auto item = result_queue.pop()) {
+                const auto write_start = Clock::now();
+                write(item->first, item->second);
+                statistics.write_seconds += seconds_since(write_start);
+                statistics.number_graphs++;
+            }
+        } catch (...) {
+            fail();
+        }
+    });
+
+    try {
+        while (auto item = loaded_queue.pop()) {
+            const auto compute_start = Clock::now();
+            auto result = compute(std::move(item->second));
+            statistics.compute_seconds += seconds_since(compute_start);
+
+            if (!result_queue.push({item->first, std::move(result)})) {
+                break;
+            }
+        }
+    } catch (...) {
+        fail();
+    }
+    result_queue.close();
+
+    loader.join();
+    writer.join();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    statistics.total_seconds = seconds_since(start);
+    return statistics;
+}
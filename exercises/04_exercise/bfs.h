@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "execution_backend.h"
+#include "graph.h"
+
+/**
+ * @brief Direction-optimizing breadth-first search (Beamer et al.) for graphs with uniform weights.
+ *      Small frontiers are expanded top-down, i.e., every frontier vertex checks its outgoing edges.
+ *      Large frontiers are expanded bottom-up, i.e., every unvisited vertex checks its incoming edges for a parent
+ *      in the frontier bitset, and stops at the first one. That skips most of the edges in the middle levels.
+ *      The object holds the scratch buffers, so it should be reused for many sources (one object per thread)
+ * @tparam Vertex The vertex type of the graph, see BasicCsrGraph
+ * @tparam Distance The distance type of the graph, see BasicCsrGraph
+ */
+template<typename Vertex, typename Distance>
+class BasicDirectionOptimizingBfs {
+    // switch to bottom-up when the frontier has more than 1 / alpha of the unexplored edges
+    static constexpr std::size_t alpha = 14;
+    // switch back to top-down when the frontier has less than 1 / beta of the vertices
+    static constexpr std::size_t beta = 24;
+
+    static constexpr auto unreachable = std::numeric_limits<Distance>::max();
+
+    const BasicCsrGraph<Vertex, Distance> &graph;
+    const BasicCsrGraph<Vertex, Distance> &reverse_graph;
+
+    std::vector<vertex_type> frontier{};
+    std::vector<vertex_type> next_frontier{};
+    std::vector<std::uint64_t> frontier_bits{};
+    std::vector<std::uint64_t> next_frontier_bits{};
+
+    std::size_t degree(vertex_type vertex_id) const {
+        return graph.offsets[vertex_id + 1] - graph.offsets[vertex_id];
+    }
+
+    static bool test_bit(const std::vector<std::uint64_t> &bits, vertex_type vertex_id) {
+        return (bits[vertex_id / 64] >> (vertex_id % 64)) & 1;
+    }
+
+    static void set_bit(std::vector<std::uint64_t> &bits, vertex_type vertex_id) {
+        bits[vertex_id / 64] |= std::uint64_t(1) << (vertex_id % 64);
+    }
+
+    /**
+     * @return The number of edges of the new frontier
+     */
+    std::size_t top_down_step(std::span<Distance> distances, Distance next_distance) {
+        std::size_t frontier_edges = 0;
+        next_frontier.clear();
+
+        for (const auto vertex_id: frontier) {
+            for (const auto neighbor_id: graph.neighbors(vertex_id)) {
+                if (distances[neighbor_id] == unreachable) {
+                    distances[neighbor_id] = next_distance;
+                    next_frontier.push_back(neighbor_id);
+                    frontier_edges += degree(neighbor_id);
+                }
+            }
+        }
+
+        frontier.swap(next_frontier);
+        return frontier_edges;
+    }
+
+    /**
+     * @return The number of vertices of the new frontier
+     */
+    std::size_t bottom_up_step(std::span<Distance> distances, Distance next_distance) {
+        const auto number_vertices = static_cast<vertex_type>(graph.size());
+        std::size_t frontier_size = 0;
+
+        std::fill(next_frontier_bits.begin(), next_frontier_bits.end(), 0);
+
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            if (distances[vertex_id] != unreachable) {
+                continue;
+            }
+
+            for (const auto parent_id: reverse_graph.neighbors(vertex_id)) {
+                if (test_bit(frontier_bits, parent_id)) {
+                    distances[vertex_id] = next_distance;
+                    set_bit(next_frontier_bits, vertex_id);
+                    frontier_size++;
+                    break;
+                }
+            }
+        }
+
+        frontier_bits.swap(next_frontier_bits);
+        return frontier_size;
+    }
+
+    void queue_to_bits() {
+        std::fill(frontier_bits.begin(), frontier_bits.end(), 0);
+        for (const auto vertex_id: frontier) {
+            set_bit(frontier_bits, vertex_id);
+        }
+    }
+
+    void bits_to_queue() {
+        frontier.clear();
+        for (std::size_t word_id = 0; word_id < frontier_bits.size(); word_id++) {
+            for (auto word = frontier_bits[word_id]; word != 0; word &= word - 1) {
+                frontier.push_back(static_cast<vertex_type>(word_id * 64 + std::countr_zero(word)));
+            }
+        }
+    }
+
+public:
+    /**
+     * @param graph The graph, all edges must have the same weight
+     * @param reverse_graph The transposed graph, see transpose_graph
+     */
+    BasicDirectionOptimizingBfs(const BasicCsrGraph<Vertex, Distance> &graph,
+                                const BasicCsrGraph<Vertex, Distance> &reverse_graph) :
+            graph(graph), reverse_graph(reverse_graph),
+            frontier_bits((graph.size() + 63) / 64), next_frontier_bits((graph.size() + 63) / 64) {
+        frontier.reserve(graph.size());
+        next_frontier.reserve(graph.size());
+    }
+
+    /**
+     * @brief Calculates the shortest paths from the source vertex, same result as dijkstra_shortest_paths
+     * @param source_vertex_id The index of the source vertex
+     * @param distances Receives the distances, i.e., distances[i] is the length of the shortest path source_vertex_id--->i,
+     *      must have one element per vertex
+     */
+    void shortest_paths(vertex_type source_vertex_id, std::span<Distance> distances) {
+        const auto number_vertices = graph.size();
+        const auto weight = graph.maximum_weight;
+
+        std::fill(distances.begin(), distances.end(), unreachable);
+        distances[source_vertex_id] = 0;
+
+        frontier.clear();
+        frontier.push_back(source_vertex_id);
+
+        auto frontier_edges = degree(source_vertex_id);
+        auto unexplored_edges = graph.number_edges();
+        auto bottom_up = false;
+        std::size_t frontier_size = 1;
+
+        for (Distance next_distance = weight; frontier_size > 0; next_distance += weight) {
+            if (!bottom_up && frontier_edges > unexplored_edges / alpha) {
+                queue_to_bits();
+                bottom_up = true;
+            }
+
+            if (bottom_up) {
+                const auto previous_frontier_size = frontier_size;
+                frontier_size = bottom_up_step(distances, next_distance);
+
+                if (frontier_size < previous_frontier_size && frontier_size < number_vertices / beta) {
+                    bits_to_queue();
+                    bottom_up = false;
+                    frontier_edges = 0;
+                    for (const auto vertex_id: frontier) {
+                        frontier_edges += degree(vertex_id);
+                    }
+                }
+            } else {
+                unexplored_edges -= std::min(unexplored_edges, frontier_edges);
+                frontier_edges = top_down_step(distances, next_distance);
+                frontier_size = frontier.size();
+            }
+        }
+    }
+};
+
+using DirectionOptimizingBfs = BasicDirectionOptimizingBfs<vertex_type, distance_type>;
+
+/**
+ * @brief Calculates the all-pairs shortest-paths of a graph with uniform weights by one direction-optimizing BFS per source
+ * @return Same layout and values as all_pairs_shortest_paths
+ */
+template<typename Vertex, typename Distance>
+std::vector<Distance> all_pairs_shortest_paths_bfs(const BasicCsrGraph<Vertex, Distance> &graph) {
+    const auto number_vertices = graph.size();
+    const auto reverse_graph = transpose_graph(graph);
+
+    std::vector<Distance> all_distances(number_vertices * number_vertices);
+    BasicDirectionOptimizingBfs<Vertex, Distance> bfs(graph, reverse_graph);
+
+    for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+        const auto offset = source_vertex_id * number_vertices;
+        bfs.shortest_paths(source_vertex_id, {all_distances.data() + offset, number_vertices});
+    }
+
+    return all_distances;
+}
+
+template<typename Vertex, typename Distance>
+std::vector<Distance> all_pairs_shortest_paths_bfs_parallel(const BasicCsrGraph<Vertex, Distance> &graph) {
+    const auto number_vertices = graph.size();
+    const auto reverse_graph = transpose_graph(graph);
+    const auto sources = order_sources_by_cost(graph);
+
+    std::vector<Distance> all_distances(number_vertices * number_vertices);
+
+    // chunk c gets the sources c, c + number_chunks, ... of the cost order, so all chunks cost about the same,
+    // a chunk builds one BFS for its sources, which lives only as long as the chunk runs
+    const auto number_chunks = std::clamp<std::size_t>(4 * static_cast<std::size_t>(parallel_number_threads()), 1,
+                                                       std::max<std::size_t>(number_vertices, 1));
+    std::vector<std::size_t> chunks(number_chunks);
+    std::iota(chunks.begin(), chunks.end(), std::size_t(0));
+
+    parallel_for_each_source(chunks, [&](vertex_type chunk_id) {
+        BasicDirectionOptimizingBfs<Vertex, Distance> bfs(graph, reverse_graph);
+
+        for (auto position = static_cast<std::size_t>(chunk_id); position < number_vertices; position += number_chunks) {
+            const auto source_vertex_id = static_cast<vertex_type>(sources[position]);
+            const auto offset = static_cast<std::size_t>(source_vertex_id) * number_vertices;
+            bfs.shortest_paths(source_vertex_id, {all_distances.data() + offset, number_vertices});
+        }
+    });
+
+    return all_distances;
+}
@@ -0,0 +1,43 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "graph.h"
+#include "graph_io.h"
+
+/**
+ * Converts a graph from the text format (see read_connectivity) into the binary graph format,
+ * which 04_exercise_apsp maps into memory without parsing:
+ *      04_exercise_convert_graph <input graph.txt> <output graph.bin>
+ */
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input graph.txt> <output graph.bin>\n";
+        return 1;
+    }
+
+    const std::filesystem::path input_path = argv[1];
+    const std::filesystem::path output_path = argv[2];
+
+    try {
+        ParseStatistics statistics{};
+
+        const auto before_reading = std::chrono::high_resolution_clock::now();
+        const auto graph = read_connectivity_csr(input_path, &statistics);
+        const auto after_reading = std::chrono::high_resolution_clock::now();
+
+        write_binary_graph(output_path, graph);
+        const auto after_writing = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Read " << graph.size() << " vertices and " << graph.number_edges() << " edges in "
+                  << (after_reading - before_reading).count() << " ns.\n";
+        std::cout << "Parsed " << statistics.number_bytes << " bytes with " << statistics.number_threads << " threads at "
+                  << statistics.megabytes_per_second() << " MB/s.\n";
+        std::cout << "Wrote " << output_path.string() << " in " << (after_writing - after_reading).count() << " ns.\n";
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
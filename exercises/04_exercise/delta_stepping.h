@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "execution_backend.h"
+#include "graph.h"
+
+#include "../06_exercise/atomic_extrema.h"
+
+/*
+ * Delta-stepping (Meyer and Sanders) runs one single-source search on several threads. The tentative distances are
+ * sorted into buckets of width delta, and all vertices of the smallest non-empty bucket are settled together:
+ *      1. the light edges (weight <= delta) of the bucket are relaxed in parallel, which may put vertices back into
+ *         the same bucket, until it stays empty
+ *      2. the heavy edges of all vertices removed from the bucket are relaxed once, they can only reach later buckets
+ * Every thread has its own buckets, so pushing a vertex is never contended, and the vertices of all threads' buckets
+ * are shared out in chunks for the relaxations. A relaxation is an atomic_fetch_min on the distance of the target.
+ * A small delta does little redundant work but needs many synchronized steps, a large one the other way round;
+ * delta = infinity is Bellman-Ford, delta = 1 on integer weights is Dijkstra with a synchronous frontier.
+ * The workers are the threads of the work-stealing pool of execution_backend.h, started together for every search.
+ */
+
+/**
+ * @brief The largest number of buckets per thread, the delta is raised until maximum_weight / delta + 2 fits
+ */
+constexpr std::size_t maximum_delta_stepping_buckets = 4096;
+
+/**
+ * @return A delta that makes a bucket hold about one edge of every vertex, the maximum weight over the average out-degree
+ */
+template<typename Graph>
+distance_type default_delta(const Graph &connectivity) {
+    const auto number_vertices = connectivity.size();
+
+    std::size_t number_edges = 0;
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        number_edges += out_degree(connectivity, vertex_id);
+    }
+
+    const auto average_degree = std::max<std::size_t>(number_edges / std::max<std::size_t>(number_vertices, 1), 1);
+    return std::max<distance_type>(maximum_edge_weight(connectivity) / static_cast<distance_type>(average_degree), 1);
+}
+
+/**
+ * @brief Calculates the shortest paths from the source vertex with delta-stepping
+ * @param connectivity The adjacency list of the graph, either as maps or in CSR layout
+ * @param source_vertex_id The index of the source vertex
+ * @param delta The width of the buckets, 0 picks default_delta. It is raised to at least
+ *      ceil(maximum weight / (maximum_delta_stepping_buckets - 2)), which bounds the buckets of every thread
+ * @param number_threads The number of threads, at most parallel_number_concurrent_tasks(), more are reduced to it
+ * @return Same as dijkstra_shortest_paths
+ */
+template<typename Graph>
+std::vector<distance_type> delta_stepping_shortest_paths(const Graph &connectivity, vertex_type source_vertex_id,
+                                                         distance_type delta = 0,
+                                                         unsigned int number_threads = parallel_number_threads()) {
+    static constexpr std::size_t chunk_size = 64;
+    static constexpr auto infinity = std::numeric_limits<distance_type>::max();
+    static constexpr auto no_bucket = std::numeric_limits<std::size_t>::max();
+
+    const auto number_vertices = connectivity.size();
+    number_threads = std::clamp(number_threads, 1u, parallel_number_concurrent_tasks());
+
+    const auto maximum_weight = maximum_edge_weight(connectivity);
+    static constexpr auto maximum_bucket_span = static_cast<distance_type>(maximum_delta_stepping_buckets - 2);
+    const auto minimum_delta = static_cast<distance_type>(maximum_weight / maximum_bucket_span +
+                                                          (maximum_weight % maximum_bucket_span != 0 ? 1 : 0));
+    delta = std::max({delta == 0 ? default_delta(connectivity) : delta, minimum_delta, distance_type(1)});
+
+    // all tentative distances are within [current bucket, current bucket + maximum weight], so the buckets can be reused
+    // cyclically
+    const auto number_buckets = static_cast<std::size_t>(maximum_weight / delta) + 2;
+    const auto bucket_of = [delta](distance_type distance) {
+        return static_cast<std::size_t>(distance / delta);
+    };
+
+    std::vector<std::atomic<distance_type>> distances(number_vertices);
+    for (auto &distance: distances) {
+        distance.store(infinity, std::memory_order::relaxed);
+    }
+    distances[source_vertex_id].store(0, std::memory_order::relaxed);
+
+    // the step (plus one) in which a vertex was last removed from a bucket, so its heavy edges are relaxed once per bucket
+    std::vector<std::atomic<std::uint32_t>> removed_in_step(number_vertices);
+    for (auto &step: removed_in_step) {
+        step.store(0, std::memory_order::relaxed);
+    }
+
+    std::vector<std::vector<std::vector<vertex_type>>> buckets(number_threads, std::vector<std::vector<vertex_type>>(number_buckets));
+    std::vector<std::vector<vertex_type>> frontiers(number_threads);
+    std::vector<std::vector<vertex_type>> removed_vertices(number_threads);
+    std::vector<std::size_t> next_buckets(number_threads, no_bucket);
+    buckets[0][0].push_back(source_vertex_id);
+
+    // shared between the synchronization points, written by thread 0 only
+    std::vector<std::size_t> frontier_offsets(number_threads + 1, 0);
+    std::atomic<std::size_t> next_chunk = 0;
+    std::size_t current_bucket = 0;
+    std::uint32_t step = 0;
+
+    std::barrier synchronization(static_cast<std::ptrdiff_t>(number_threads));
+
+    // a thread that throws sets failed and drops out of the barrier, the others leave at their next synchronization point
+    struct SearchAborted {};
+    std::atomic<bool> failed = false;
+    const auto synchronize = [&synchronization, &failed] {
+        synchronization.arrive_and_wait();
+        if (failed.load(std::memory_order::relaxed)) {
+            throw SearchAborted{};
+        }
+    };
+
+    const auto search = [&](std::size_t thread_id) {
+        auto &own_buckets = buckets[thread_id];
+
+        const auto relax = [&](vertex_type vertex_id, distance_type new_distance) {
+            if (atomic_fetch_min(&distances[vertex_id], new_distance, std::memory_order::relaxed) > new_distance) {
+                own_buckets[bucket_of(new_distance) % number_buckets].push_back(vertex_id);
+            }
+        };
+
+        // thread 0 lays out the frontiers of all threads one after the other, then all threads take chunks of them
+        const auto for_each_frontier_vertex = [&](auto &&function) {
+            synchronize();
+            if (thread_id == 0) {
+                for (unsigned int other_thread_id = 0; other_thread_id < number_threads; other_thread_id++) {
+                    frontier_offsets[other_thread_id + 1] = frontier_offsets[other_thread_id] + frontiers[other_thread_id].size();
+                }
+                next_chunk.store(0, std::memory_order::relaxed);
+            }
+            synchronize();
+
+            const auto total_size = frontier_offsets.back();
+            for (auto first = next_chunk.fetch_add(chunk_size); first < total_size; first = next_chunk.fetch_add(chunk_size)) {
+                const auto last = std::min(first + chunk_size, total_size);
+                auto frontier_id = static_cast<std::size_t>(
+                        std::upper_bound(frontier_offsets.begin(), frontier_offsets.end(), first) - frontier_offsets.begin() - 1);
+
+                for (auto position = first; position < last; position++) {
+                    while (position >= frontier_offsets[frontier_id + 1]) {
+                        frontier_id++;
+                    }
+                    function(frontiers[frontier_id][position - frontier_offsets[frontier_id]]);
+                }
+            }
+
+            // nobody may refill a frontier another thread is still reading
+            synchronize();
+
+            return total_size;
+        };
+
+        while (true) {
+            // light edges, until the current bucket stays empty
+            while (true) {
+                frontiers[thread_id].clear();
+                frontiers[thread_id].swap(own_buckets[current_bucket % number_buckets]);
+
+                const auto frontier_size = for_each_frontier_vertex([&](vertex_type vertex_id) {
+                    const auto distance = distances[vertex_id].load(std::memory_order::relaxed);
+                    // a stale entry, the vertex was improved into an earlier bucket after it was queued in this one
+                    if (bucket_of(distance) != current_bucket) {
+                        return;
+                    }
+
+                    if (removed_in_step[vertex_id].exchange(step + 1, std::memory_order::relaxed) != step + 1) {
+                        removed_vertices[thread_id].push_back(vertex_id);
+                    }
+
+                    for_each_neighbor(connectivity, vertex_id, [&](vertex_type target_vertex_id, distance_type edge_weight) {
+                        if (edge_weight <= delta) {
+                            relax(target_vertex_id, distance + edge_weight);
+                        }
+                    });
+                });
+
+                if (frontier_size == 0) {
+                    break;
+                }
+            }
+
+            // heavy edges of everything that left the bucket, their distances are final now
+            frontiers[thread_id].swap(removed_vertices[thread_id]);
+            removed_vertices[thread_id].clear();
+
+            for_each_frontier_vertex([&](vertex_type vertex_id) {
+                const auto distance = distances[vertex_id].load(std::memory_order::relaxed);
+
+                for_each_neighbor(connectivity, vertex_id, [&](vertex_type target_vertex_id, distance_type edge_weight) {
+                    if (edge_weight > delta) {
+                        relax(target_vertex_id, distance + edge_weight);
+                    }
+                });
+            });
+
+            // the next non-empty bucket over all threads
+            next_buckets[thread_id] = no_bucket;
+            for (std::size_t offset = 1; offset < number_buckets; offset++) {
+                if (!own_buckets[(current_bucket + offset) % number_buckets].empty()) {
+                    next_buckets[thread_id] = current_bucket + offset;
+                    break;
+                }
+            }
+
+            synchronize();
+            if (thread_id == 0) {
+                current_bucket = *std::min_element(next_buckets.begin(), next_buckets.end());
+                step++;
+            }
+            synchronize();
+
+            if (current_bucket == no_bucket) {
+                return;
+            }
+        }
+    };
+
+    run_together_on_parallel_work_stealing_pool(number_threads, [&](std::size_t thread_id) {
+        try {
+            search(thread_id);
+        } catch (const SearchAborted &) {
+        } catch (...) {
+            failed.store(true, std::memory_order::relaxed);
+            synchronization.arrive_and_drop();
+            throw;
+        }
+    });
+
+    std::vector<distance_type> result(number_vertices);
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        result[vertex_id] = distances[vertex_id].load(std::memory_order::relaxed);
+    }
+
+    return result;
+}
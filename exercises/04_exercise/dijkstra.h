@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "graph.h"
+#include "priority_queues.h"
+
+/**
+ * @brief The queue of the searches of one thread. It is reused for all sources, so a search does not allocate once the
+ *		queue has grown to the size of the graph, and the queue is reset instead of rebuilt, see priority_queues.h
+ */
+template<typename Queue>
+class DijkstraWorkspace {
+    std::optional<Queue> queue_storage{};
+    std::size_t queue_number_vertices = 0;
+    distance_type queue_maximum_edge_weight = 0;
+
+public:
+    /**
+     * @return The workspace of the calling thread
+     */
+    static DijkstraWorkspace &local() {
+        thread_local DijkstraWorkspace workspace{};
+        return workspace;
+    }
+
+    /**
+     * @return An empty queue for a graph with the specified size, rebuilt only if the graph differs from the last one
+     */
+    Queue &queue(std::size_t number_vertices, distance_type maximum_edge_weight) {
+        if (!queue_storage || queue_number_vertices != number_vertices || queue_maximum_edge_weight != maximum_edge_weight) {
+            queue_storage.emplace(number_vertices, maximum_edge_weight);
+            queue_number_vertices = number_vertices;
+            queue_maximum_edge_weight = maximum_edge_weight;
+        } else {
+            queue_storage->reset();
+        }
+        return *queue_storage;
+    }
+};
+
+/**
+ * @brief Calculated the shortest paths from the specified source vertex using the connectivity,
+ *		with the queue of DijkstraWorkspace, so it does not allocate
+ * @tparam Queue The priority queue policy, see priority_queues.h
+ * @param connectivity The adjacency list of the graph, either as maps or in CSR layout
+ * @param source_vertex_id The index of the source vertex from which the shortest path to all vertices should be calculated
+ * @param distances Receives the shortest paths as the distance type of the graph, e.g., a row of the distance matrix,
+ *		must have one element per vertex, i.e.,
+ *		for all vertices i, the shortest path source_vertex_id--->i has the distance k,
+ *		<distances>[i] = k
+ */
+template<typename Queue = BinaryHeapQueue, typename Graph, typename Distance>
+void dijkstra_shortest_paths(const Graph &connectivity, vertex_type source_vertex_id, std::span<Distance> distances) {
+    static_assert(std::is_same_v<Distance, graph_distance_t<Graph>>, "the row must have the distance type of the graph");
+
+    const auto number_vertices = connectivity.size();
+    std::fill(distances.begin(), distances.end(), std::numeric_limits<Distance>::max());
+
+    // scanning all weights of an adjacency list of maps costs as much as the search, so only the queues that need it get it
+    const auto maximum_weight = Queue::uses_maximum_edge_weight ? maximum_edge_weight(connectivity) : distance_type(0);
+    auto &shortest_paths_queue = DijkstraWorkspace<Queue>::local().queue(number_vertices, maximum_weight);
+
+    distances[source_vertex_id] = 0;
+    shortest_paths_queue.push(source_vertex_id, 0);
+
+    while (!shortest_paths_queue.empty()) {
+        const auto [current_vertex_id, current_distance] = shortest_paths_queue.pop();
+
+        // stale entry of a queue with lazy deletion, the vertex was already settled with a smaller distance
+        if (current_distance > distances[current_vertex_id]) {
+            continue;
+        }
+
+        for_each_neighbor(connectivity, current_vertex_id, [&](vertex_type vertex_id, distance_type edge_weight) {
+            // the queues calculate in distance_type, a narrower Distance holds every path of the graph, see narrow_types.h
+            const auto new_distance = current_distance + edge_weight;
+            if (new_distance < distances[vertex_id]) {
+                distances[vertex_id] = static_cast<Distance>(new_distance);
+                shortest_paths_queue.push(vertex_id, new_distance);
+            }
+        });
+    }
+}
+
+/**
+ * @brief Same as above, but returns the shortest paths in a new vector
+ */
+template<typename Queue = BinaryHeapQueue, typename Graph>
+std::vector<graph_distance_t<Graph>>
+dijkstra_shortest_paths(const Graph &connectivity, vertex_type source_vertex_id) {
+    std::vector<graph_distance_t<Graph>> distances(connectivity.size());
+    dijkstra_shortest_paths<Queue>(connectivity, source_vertex_id, std::span(distances));
+    return distances;
+}
+
+/**
+ * @brief Same as dijkstra_shortest_paths, but writes the distances into the given row and also records the shortest-path tree
+ * @tparam Predecessor An unsigned integer type that can hold every vertex index and, as its maximum, the marker of no predecessor
+ * @param distances Receives the shortest paths, must have one element per vertex
+ * @param predecessors Receives the tree, i.e., <predecessors>[i] = j indicates that
+ *		j is the vertex before i on a shortest path source_vertex_id--->i, the source and the unreachable vertices get
+ *		std::numeric_limits<Predecessor>::max()
+ */
+template<typename Queue = BinaryHeapQueue, typename Graph, typename Predecessor>
+void dijkstra_shortest_path_tree(const Graph &connectivity, vertex_type source_vertex_id,
+                                 std::span<distance_type> distances, std::span<Predecessor> predecessors) {
+    const auto number_vertices = connectivity.size();
+    std::fill(distances.begin(), distances.end(), std::numeric_limits<distance_type>::max());
+    std::fill(predecessors.begin(), predecessors.end(), std::numeric_limits<Predecessor>::max());
+
+    const auto maximum_weight = Queue::uses_maximum_edge_weight ? maximum_edge_weight(connectivity) : distance_type(0);
+    auto &shortest_paths_queue = DijkstraWorkspace<Queue>::local().queue(number_vertices, maximum_weight);
+
+    distances[source_vertex_id] = 0;
+    shortest_paths_queue.push(source_vertex_id, 0);
+
+    while (!shortest_paths_queue.empty()) {
+        const auto [current_vertex_id, current_distance] = shortest_paths_queue.pop();
+
+        if (current_distance > distances[current_vertex_id]) {
+            continue;
+        }
+
+        for_each_neighbor(connectivity, current_vertex_id, [&](vertex_type vertex_id, distance_type edge_weight) {
+            const auto new_distance = current_distance + edge_weight;
+            if (new_distance < distances[vertex_id]) {
+                distances[vertex_id] = new_distance;
+                predecessors[vertex_id] = static_cast<Predecessor>(current_vertex_id);
+                shortest_paths_queue.push(vertex_id, new_distance);
+            }
+        });
+    }
+}
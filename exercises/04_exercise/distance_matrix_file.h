@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "graph.h"
+#include "mapped_file.h"
+
+/*
+ * The distance matrix file stores the result of an APSP run so other processes can query it without recalculating
+ * or reading it. All of them map the file, so the host keeps one copy of the matrix in the page cache, and a query
+ * only faults in the pages it touches:
+ *      DistanceMatrixHeader
+ *      furthest_reaching_vertex : VertexDistancePair[number_vertices]
+ *      distances                : distance_type[number_vertices * number_vertices], row-major, page-aligned
+ */
+constexpr std::array<char, 8> distance_matrix_magic = {'A', 'P', 'S', 'P', 'D', 'I', 'S', 'T'};
+constexpr std::uint32_t distance_matrix_version = 1;
+constexpr std::uint64_t distance_matrix_alignment = 4096;
+
+struct DistanceMatrixHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint32_t vertex_size;
+    std::uint32_t distance_size;
+    std::uint64_t number_vertices;
+    std::uint64_t furthest_reaching_vertex_position;
+    std::uint64_t distances_position;
+    std::uint64_t file_size;
+};
+
+static_assert(std::endian::native == std::endian::little, "the distance matrix format is little-endian");
+static_assert(sizeof(VertexDistancePair) == sizeof(vertex_type) + sizeof(distance_type));
+
+/**
+ * @brief Writes an APSP result in the distance matrix format. The file is written next to the destination and
+ *      renamed over it, so processes that have the old file mapped keep a consistent view of it
+ * @param path The path to the file that is created or replaced
+ * @param all_distances The distance matrix (same layout as all_pairs_shortest_paths)
+ * @param furthest_reaching_vertex The furthest reaching vertex of every vertex (same as calculate_largest_smallest_path)
+ */
+inline void write_distance_matrix(const std::filesystem::path &path, std::span<const distance_type> all_distances,
+                                  std::span<const VertexDistancePair> furthest_reaching_vertex) {
+    const auto number_vertices = static_cast<std::uint64_t>(furthest_reaching_vertex.size());
+    if (all_distances.size() != number_vertices * number_vertices) {
+        throw std::invalid_argument("the distance matrix does not match the number of vertices");
+    }
+
+    DistanceMatrixHeader header{};
+    header.magic = distance_matrix_magic;
+    header.version = distance_matrix_version;
+    header.header_size = sizeof(DistanceMatrixHeader);
+    header.vertex_size = sizeof(vertex_type);
+    header.distance_size = sizeof(distance_type);
+    header.number_vertices = number_vertices;
+    header.furthest_reaching_vertex_position = sizeof(DistanceMatrixHeader);
+    header.distances_position = (header.furthest_reaching_vertex_position + furthest_reaching_vertex.size_bytes() +
+                                 distance_matrix_alignment - 1) / distance_matrix_alignment * distance_matrix_alignment;
+    header.file_size = header.distances_position + all_distances.size_bytes();
+
+    auto temporary_path = path;
+    temporary_path += ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("cannot create " + temporary_path.string());
+        }
+
+        const std::vector<char> padding(header.distances_position - header.furthest_reaching_vertex_position -
+                                        furthest_reaching_vertex.size_bytes());
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(furthest_reaching_vertex.data()),
+                   static_cast<std::streamsize>(furthest_reaching_vertex.size_bytes()));
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char *>(all_distances.data()), static_cast<std::streamsize>(all_distances.size_bytes()));
+
+        if (!file.flush()) {
+            throw std::runtime_error("cannot write " + temporary_path.string());
+        }
+    }
+
+    std::filesystem::rename(temporary_path, path);
+}
+
+/**
+ * @brief Read-only queries on a mapped distance matrix file. Nothing is loaded up front,
+ *      every query reads the mapped pages directly
+ */
+class DistanceMatrixFile {
+    // how many lookups ahead a batch prefetches, enough to hide the DRAM latency of a lookup
+    static constexpr std::size_t prefetch_distance = 16;
+
+    std::shared_ptr<const MappedFile> mapped_file{};
+    std::size_t vertex_count = 0;
+    std::span<const VertexDistancePair> furthest{};
+    const distance_type *distances = nullptr;
+
+    void check_vertex(vertex_type vertex_id) const {
+        if (vertex_id < 0 || static_cast<std::size_t>(vertex_id) >= vertex_count) {
+            throw std::out_of_range("vertex " + std::to_string(vertex_id) + " is not in the distance matrix");
+        }
+    }
+
+    const distance_type *address(vertex_type source_vertex_id, vertex_type target_vertex_id) const {
+        return distances + static_cast<std::size_t>(source_vertex_id) * vertex_count + target_vertex_id;
+    }
+
+public:
+    explicit DistanceMatrixFile(const std::filesystem::path &path) :
+            mapped_file(std::make_shared<const MappedFile>(path)) {
+        const auto bytes = mapped_file->bytes();
+
+        DistanceMatrixHeader header{};
+        if (bytes.size() < sizeof(header)) {
+            throw std::runtime_error(path.string() + " is too small for a distance matrix");
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+
+        if (header.magic != distance_matrix_magic) {
+            throw std::runtime_error(path.string() + " is not a distance matrix");
+        }
+        if (header.version != distance_matrix_version || header.header_size != sizeof(DistanceMatrixHeader)) {
+            throw std::runtime_error(path.string() + " has an unsupported distance matrix version");
+        }
+        if (header.vertex_size != sizeof(vertex_type) || header.distance_size != sizeof(distance_type)) {
+            throw std::runtime_error(path.string() + " was written with different vertex or distance types");
+        }
+
+        // count elements of element_size fit into the file from position on, without overflowing
+        const auto section_fits = [&bytes](std::uint64_t position, std::uint64_t count, std::uint64_t element_size) {
+            return position <= bytes.size() && count <= (bytes.size() - position) / element_size;
+        };
+
+        const auto number_vertices = header.number_vertices;
+        if (number_vertices > static_cast<std::uint64_t>(std::numeric_limits<vertex_type>::max())) {
+            throw std::runtime_error(path.string() + " has more vertices than vertex_type can index");
+        }
+
+        // the sections follow each other in the order of the top of this file, so they cannot overlap. With at most
+        // INT_MAX vertices, the section sizes cannot overflow either
+        if (header.file_size != bytes.size() ||
+            header.furthest_reaching_vertex_position < sizeof(DistanceMatrixHeader) ||
+            header.furthest_reaching_vertex_position % alignof(VertexDistancePair) != 0 ||
+            !section_fits(header.furthest_reaching_vertex_position, number_vertices, sizeof(VertexDistancePair)) ||
+            header.distances_position < header.furthest_reaching_vertex_position + number_vertices * sizeof(VertexDistancePair) ||
+            header.distances_position % distance_matrix_alignment != 0 ||
+            !section_fits(header.distances_position, number_vertices * number_vertices, sizeof(distance_type))) {
+            throw std::runtime_error(path.string() + " is truncated or corrupted");
+        }
+
+        vertex_count = header.number_vertices;
+        furthest = {reinterpret_cast<const VertexDistancePair *>(bytes.data() + header.furthest_reaching_vertex_position),
+                    vertex_count};
+        distances = reinterpret_cast<const distance_type *>(bytes.data() + header.distances_position);
+
+        // lookups jump around the matrix, read-ahead would mostly fetch pages nobody asked for
+        mapped_file->advise(MADV_RANDOM);
+    }
+
+    std::size_t number_vertices() const {
+        return vertex_count;
+    }
+
+    /**
+     * @return The length of the shortest path source_vertex_id--->target_vertex_id
+     */
+    distance_type distance(vertex_type source_vertex_id, vertex_type target_vertex_id) const {
+        check_vertex(source_vertex_id);
+        check_vertex(target_vertex_id);
+        return *address(source_vertex_id, target_vertex_id);
+    }
+
+    /**
+     * @return The shortest paths from source_vertex_id, i.e., <return>[i] is the length of source_vertex_id--->i
+     */
+    std::span<const distance_type> row(vertex_type source_vertex_id) const {
+        check_vertex(source_vertex_id);
+        return {address(source_vertex_id, 0), vertex_count};
+    }
+
+    /**
+     * @return The vertex with the longest shortest path to target_vertex_id and its distance
+     */
+    VertexDistancePair furthest_reaching_vertex(vertex_type target_vertex_id) const {
+        check_vertex(target_vertex_id);
+        return furthest[target_vertex_id];
+    }
+
+    /**
+     * @brief Answers a batch of (source, target) lookups. The entries of the next lookups are prefetched
+     *      while the current one is read, so the cache misses of a batch overlap. Prefetches of pages that are
+     *      not resident yet are dropped by the CPU, those still fault in one by one
+     * @param queries The (source, target) pairs
+     * @param results Receives the distances, must have one element per query
+     */
+    void distances_batch(std::span<const std::pair<vertex_type, vertex_type>> queries, std::span<distance_type> results) const {
+        if (results.size() != queries.size()) {
+            throw std::invalid_argument("the batch needs one result per query");
+        }
+        for (const auto &[source_vertex_id, target_vertex_id]: queries) {
+            check_vertex(source_vertex_id);
+            check_vertex(target_vertex_id);
+        }
+
+        for (std::size_t query_id = 0; query_id < queries.size(); query_id++) {
+            if (query_id + prefetch_distance < queries.size()) {
+                const auto &[source_vertex_id, target_vertex_id] = queries[query_id + prefetch_distance];
+                __builtin_prefetch(address(source_vertex_id, target_vertex_id), 0, 0);
+            }
+
+            const auto &[source_vertex_id, target_vertex_id] = queries[query_id];
+            results[query_id] = *address(source_vertex_id, target_vertex_id);
+        }
+    }
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "dijkstra.h"
+#include "execution_backend.h"
+#include "floyd_warshall.h"
+#include "graph.h"
+#include "perf_counters.h"
+
+/*
+ * calculate_largest_smallest_path returns, for every vertex t, the in-eccentricity ecc(t) = max_s d(s, t) and a vertex
+ * that attains it. This file bounds them from a few single-source searches instead of one per vertex. A search forward
+ * and one backward (on the transposed graph) from a vertex v give d(v, t) and d(s, v) for all s and t, so
+ *      ecc(v) = max_s d(s, v)                          exactly
+ *      d(v, t) <= ecc(t) <= ecc(v) + d(v, t)           for every t, by the triangle inequality
+ * and the lower bound is attained by v. Once the bounds of t meet, ecc(t) is known. Like BoundingDiameters
+ * (Takes and Kosters), the exact engine keeps choosing the next v among the open vertices, alternating the largest
+ * upper bound and the smallest lower bound, until no vertex is open. On graphs with a small-world structure, this takes
+ * a small fraction of the number of vertices. The sampled engine runs a fixed number of random v and reports the bounds
+ * it reached, the lower bounds are the estimate and the upper bounds the error bound.
+ * Ties may be resolved with another vertex than calculate_largest_smallest_path picks, the distances are the same.
+ */
+
+/**
+ * @brief The bounds of all in-eccentricities, see the top of this file
+ */
+class EccentricityBounds {
+    static constexpr auto infinity = std::numeric_limits<distance_type>::max();
+
+    CsrGraph graph;
+    CsrGraph reverse_graph;
+    std::vector<VertexDistancePair> lower_bounds;
+    std::vector<distance_type> upper_bounds;
+    std::size_t searches = 0;
+
+public:
+    explicit EccentricityBounds(const CsrGraph &connectivity) :
+            graph(connectivity), reverse_graph(transpose_graph(connectivity)),
+            lower_bounds(connectivity.size()), upper_bounds(connectivity.size(), infinity) {
+        for (vertex_type vertex_id = 0; vertex_id < static_cast<vertex_type>(graph.size()); vertex_id++) {
+            lower_bounds[vertex_id] = {vertex_id, 0};
+        }
+    }
+
+    bool is_open(vertex_type vertex_id) const {
+        return lower_bounds[vertex_id].distance < upper_bounds[vertex_id];
+    }
+
+    /**
+     * @brief Runs the forward and the backward search from the vertex and tightens the bounds of all vertices
+     */
+    void add_source(vertex_type source_vertex_id) {
+        // the forward search on graph and the backward one on reverse_graph
+        std::array<std::vector<distance_type>, 2> distances{};
+        const std::array<const CsrGraph *, 2> graphs = {&graph, &reverse_graph};
+        static const std::vector<std::size_t> directions = {0, 1};
+        parallel_for_each_source(directions, [&](vertex_type direction) {
+            distances[direction] = dijkstra_shortest_paths(*graphs[direction], source_vertex_id);
+        });
+        searches += 2;
+
+        const auto &forward_distances = distances[0];
+        const auto &backward_distances = distances[1];
+
+        // the first largest one, like calculate_largest_smallest_path
+        VertexDistancePair eccentricity{source_vertex_id, 0};
+        for (vertex_type vertex_id = 0; vertex_id < static_cast<vertex_type>(graph.size()); vertex_id++) {
+            if (backward_distances[vertex_id] > eccentricity.distance) {
+                eccentricity = {vertex_id, backward_distances[vertex_id]};
+            }
+        }
+
+        // a bound update is a few instructions, so every task takes a range of vertices
+        static constexpr std::size_t range_size = 4096;
+        const auto number_vertices = graph.size();
+        std::vector<std::size_t> ranges((number_vertices + range_size - 1) / range_size);
+        std::iota(ranges.begin(), ranges.end(), std::size_t(0));
+
+        parallel_for_each_source(ranges, [&](vertex_type range_id) {
+            const auto first_vertex_id = static_cast<std::size_t>(range_id) * range_size;
+            const auto last_vertex_id = std::min(first_vertex_id + range_size, number_vertices);
+
+            for (auto vertex_id = first_vertex_id; vertex_id < last_vertex_id; vertex_id++) {
+                if (forward_distances[vertex_id] > lower_bounds[vertex_id].distance) {
+                    lower_bounds[vertex_id] = {source_vertex_id, forward_distances[vertex_id]};
+                }
+                upper_bounds[vertex_id] = std::min(upper_bounds[vertex_id],
+                                                   saturating_add(eccentricity.distance, forward_distances[vertex_id]));
+            }
+        });
+
+        lower_bounds[source_vertex_id] = eccentricity;
+        upper_bounds[source_vertex_id] = eccentricity.distance;
+    }
+
+    /**
+     * @return The open vertex with the largest upper bound (or the smallest lower bound), ties broken by the larger
+     *      degree, -1 if all vertices are exact
+     */
+    vertex_type select_source(bool largest_upper_bound) const {
+        vertex_type selected_vertex_id = -1;
+
+        for (vertex_type vertex_id = 0; vertex_id < static_cast<vertex_type>(graph.size()); vertex_id++) {
+            if (!is_open(vertex_id)) {
+                continue;
+            }
+            if (selected_vertex_id < 0) {
+                selected_vertex_id = vertex_id;
+                continue;
+            }
+
+            const auto key = [&](vertex_type candidate_vertex_id) {
+                const auto bound = largest_upper_bound ? upper_bounds[candidate_vertex_id]
+                                                       : infinity - lower_bounds[candidate_vertex_id].distance;
+                return std::make_pair(bound, out_degree(graph, candidate_vertex_id) + out_degree(reverse_graph, candidate_vertex_id));
+            };
+            if (key(vertex_id) > key(selected_vertex_id)) {
+                selected_vertex_id = vertex_id;
+            }
+        }
+
+        return selected_vertex_id;
+    }
+
+    std::size_t number_open() const {
+        std::size_t open = 0;
+        for (vertex_type vertex_id = 0; vertex_id < static_cast<vertex_type>(graph.size()); vertex_id++) {
+            open += is_open(vertex_id) ? 1 : 0;
+        }
+        return open;
+    }
+
+    /**
+     * @return The number of single-source searches so far, forward and backward counted separately
+     */
+    std::size_t number_searches() const {
+        return searches;
+    }
+
+    /**
+     * @return Same layout as calculate_largest_smallest_path, exact for the vertices that are not open,
+     *      a lower bound attained by the returned vertex for the others
+     */
+    const std::vector<VertexDistancePair> &furthest_reaching_vertex() const {
+        return lower_bounds;
+    }
+
+    const std::vector<distance_type> &upper_bound() const {
+        return upper_bounds;
+    }
+
+    /**
+     * @return The largest upper_bound / lower bound - 1 over all vertices with a finite upper bound, 0 if exact,
+     *      infinity if a vertex has no finite upper bound yet
+     */
+    double maximum_relative_error() const {
+        double error = 0;
+        for (vertex_type vertex_id = 0; vertex_id < static_cast<vertex_type>(graph.size()); vertex_id++) {
+            if (!is_open(vertex_id)) {
+                continue;
+            }
+            if (upper_bounds[vertex_id] == infinity || lower_bounds[vertex_id].distance == 0) {
+                return std::numeric_limits<double>::infinity();
+            }
+            error = std::max(error, static_cast<double>(upper_bounds[vertex_id]) / lower_bounds[vertex_id].distance - 1);
+        }
+        return error;
+    }
+};
+
+/**
+ * @brief Same result as calculate_largest_smallest_path on the all-pairs shortest-paths of the graph,
+ *      calculated from as few searches as the bounds allow, see the top of this file
+ * @param number_searches If not nullptr, receives the number of single-source searches
+ */
+inline std::vector<VertexDistancePair> calculate_largest_smallest_path_bounded(const CsrGraph &connectivity,
+                                                                               std::size_t *number_searches = nullptr) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+
+    EccentricityBounds bounds(connectivity);
+
+    auto largest_upper_bound = true;
+    for (auto vertex_id = bounds.select_source(largest_upper_bound); vertex_id >= 0;
+         vertex_id = bounds.select_source(largest_upper_bound)) {
+        bounds.add_source(vertex_id);
+        largest_upper_bound = !largest_upper_bound;
+    }
+
+    if (number_searches != nullptr) {
+        *number_searches = bounds.number_searches();
+    }
+
+    return bounds.furthest_reaching_vertex();
+}
+
+/**
+ * @brief Bounds the in-eccentricities from the searches of number_samples random vertices
+ * @return The bounds, furthest_reaching_vertex() is the estimate, upper_bound() and maximum_relative_error() its error
+ */
+inline EccentricityBounds sample_largest_smallest_path(const CsrGraph &connectivity, std::size_t number_samples,
+                                                       std::uint64_t seed = 42) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+
+    EccentricityBounds bounds(connectivity);
+
+    std::vector<vertex_type> vertices(connectivity.size());
+    std::iota(vertices.begin(), vertices.end(), vertex_type(0));
+    std::mt19937_64 generator(seed);
+    std::shuffle(vertices.begin(), vertices.end(), generator);
+
+    for (std::size_t sample_id = 0; sample_id < std::min(number_samples, vertices.size()); sample_id++) {
+        bounds.add_source(vertices[sample_id]);
+    }
+
+    return bounds;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <execution>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(APSP_BACKEND_OPENMP)
+#include <omp.h>
+#elif defined(APSP_BACKEND_STD_PAR) && defined(APSP_HAS_TBB)
+#include <tbb/global_control.h>
+#define APSP_HAS_TBB_GLOBAL_CONTROL 1
+#endif
+
+#include "graph.h"
+#include "work_stealing_pool.h"
+
+/*
+ * The per-source loops of the APSP engines run on one of three backends, chosen when building
+ * (-DAPSP_PARALLEL_BACKEND=work_stealing|std_par|openmp, see CMakeLists.txt):
+ *      work_stealing   WorkStealingPool, the default
+ *      std_par         std::for_each(std::execution::par, ...), with libstdc++ this needs TBB, otherwise it is serial
+ *      openmp          #pragma omp parallel for with dynamic scheduling
+ * All of them get the sources sorted by decreasing estimated cost, so the expensive sources start first.
+ */
+
+inline const char *parallel_backend_name() {
+#if defined(APSP_BACKEND_OPENMP)
+    return "openmp";
+#elif defined(APSP_BACKEND_STD_PAR)
+    return "std_par";
+#else
+    return "work_stealing";
+#endif
+}
+
+/**
+ * @brief The number of threads of the per-source loops. Defaults to the environment variable APSP_NUM_THREADS
+ *      or, if it is not set, to the number of hardware threads
+ */
+inline unsigned int &parallel_number_threads() {
+    static unsigned int number_threads = [] {
+        if (const auto *value = std::getenv("APSP_NUM_THREADS"); value != nullptr && std::atoi(value) > 0) {
+            return static_cast<unsigned int>(std::atoi(value));
+        }
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }();
+
+    return number_threads;
+}
+
+inline void set_parallel_number_threads(unsigned int number_threads) {
+    parallel_number_threads() = std::max(number_threads, 1u);
+}
+
+/**
+ * @brief Calls function(pool) with the work-stealing pool of the per-source loops. The pool is shared by all callers and
+ *      recreated when the number of threads changes, both under a mutex, so concurrent calls from different threads run
+ *      one after the other. Must not be called from inside a task of the pool
+ */
+inline void with_parallel_work_stealing_pool(const std::function<void(WorkStealingPool &)> &function) {
+    static std::mutex pool_mutex{};
+    static std::unique_ptr<WorkStealingPool> pool{};
+
+    const std::lock_guard<std::mutex> lock(pool_mutex);
+
+    if (pool == nullptr || pool->number_threads() != parallel_number_threads()) {
+        pool.reset();
+        pool = std::make_unique<WorkStealingPool>(parallel_number_threads());
+    }
+
+    function(*pool);
+}
+
+/**
+ * @brief Runs function(task) for every task on the work-stealing pool of the per-source loops, see
+ *      with_parallel_work_stealing_pool. A call from inside a task runs its tasks serially on that worker instead
+ */
+inline void run_on_parallel_work_stealing_pool(std::span<const std::size_t> tasks,
+                                               const std::function<void(std::size_t)> &function) {
+    if (WorkStealingPool::inside_task()) {
+        std::for_each(tasks.begin(), tasks.end(), function);
+        return;
+    }
+
+    with_parallel_work_stealing_pool([&](WorkStealingPool &pool) {
+        pool.run(tasks, [&function](std::size_t task, unsigned int) {
+            function(task);
+        });
+    });
+}
+
+/**
+ * @return The number of tasks that run_together_on_parallel_work_stealing_pool can run at the same time from the calling
+ *      thread, 1 inside a task of the pool
+ */
+inline unsigned int parallel_number_concurrent_tasks() {
+    return WorkStealingPool::inside_task() ? 1u : parallel_number_threads();
+}
+
+/**
+ * @brief Runs function(task) for the tasks 0, ..., number_tasks - 1 at the same time on the work-stealing pool of the
+ *      per-source loops, see WorkStealingPool::run_together. A single task runs on the calling thread
+ * @param number_tasks At most parallel_number_concurrent_tasks()
+ */
+inline void run_together_on_parallel_work_stealing_pool(std::size_t number_tasks,
+                                                        const std::function<void(std::size_t)> &function) {
+    if (number_tasks == 1) {
+        function(0);
+        return;
+    }
+
+    with_parallel_work_stealing_pool([&](WorkStealingPool &pool) {
+        pool.run_together(number_tasks, function);
+    });
+}
+
+/**
+ * @brief How the cost of a single-source search is estimated to order the sources
+ *      out_degree         the number of outgoing edges of the source
+ *      two_hop_degree     the number of edges of the source and of its neighbors, a cheap proxy for the
+ *                         size of the reachable set which separates sources in sinks or small components from the rest
+ */
+enum class SourceCostEstimate {
+    out_degree,
+    two_hop_degree,
+};
+
+/**
+ * @brief Returns all vertices sorted by decreasing estimated cost of a search from them
+ */
+template<typename Graph>
+std::vector<std::size_t> order_sources_by_cost(const Graph &connectivity,
+                                               SourceCostEstimate estimate = SourceCostEstimate::two_hop_degree) {
+    const auto number_vertices = connectivity.size();
+
+    std::vector<std::size_t> costs(number_vertices, 0);
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        costs[vertex_id] = out_degree(connectivity, vertex_id);
+    }
+
+    if (estimate == SourceCostEstimate::two_hop_degree) {
+        std::vector<std::size_t> two_hop_costs(costs);
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            for_each_neighbor(connectivity, vertex_id, [&](vertex_type neighbor_id, distance_type) {
+                two_hop_costs[vertex_id] += costs[neighbor_id];
+            });
+        }
+        costs = std::move(two_hop_costs);
+    }
+
+    std::vector<std::size_t> sources(number_vertices);
+    std::iota(sources.begin(), sources.end(), std::size_t(0));
+    std::stable_sort(sources.begin(), sources.end(), [&costs](std::size_t lhs, std::size_t rhs) {
+        return costs[lhs] > costs[rhs];
+    });
+
+    return sources;
+}
+
+/**
+ * @brief Runs function(source_vertex_id) for every source on the parallel backend chosen when building
+ * @param sources The sources, preferably sorted by decreasing cost, see order_sources_by_cost
+ */
+template<typename Function>
+void parallel_for_each_source(const std::vector<std::size_t> &sources, Function &&function) {
+#if defined(APSP_BACKEND_OPENMP)
+    const auto number_sources = static_cast<long long>(sources.size());
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(parallel_number_threads())
+    for (long long source_id = 0; source_id < number_sources; source_id++) {
+        function(static_cast<vertex_type>(sources[source_id]));
+    }
+#elif defined(APSP_BACKEND_STD_PAR)
+#ifdef APSP_HAS_TBB_GLOBAL_CONTROL
+    tbb::global_control thread_limit(tbb::global_control::max_allowed_parallelism, parallel_number_threads());
+#endif
+
+    std::for_each(std::execution::par, sources.begin(), sources.end(), [&function](std::size_t source_vertex_id) {
+        function(static_cast<vertex_type>(source_vertex_id));
+    });
+#else
+    run_on_parallel_work_stealing_pool(sources, [&function](std::size_t source_vertex_id) {
+        function(static_cast<vertex_type>(source_vertex_id));
+    });
+#endif
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define APSP_HAS_X86_SIMD 1
+#endif
+
+#include "execution_backend.h"
+#include "graph.h"
+#include "perf_counters.h"
+
+/*
+ * 64 x 64 tiles of 4-byte distances are 16 KiB, so the three tiles of one min-plus update fit into L1/L2
+ */
+constexpr std::size_t floyd_warshall_block_size = 64;
+
+/**
+ * @brief Adds two distances, and saturates at std::numeric_limits<distance_type>::max(),
+ *      i.e., a path over an unreachable vertex stays unreachable
+ */
+inline distance_type saturating_add(distance_type lhs, distance_type rhs) {
+    const distance_type sum = lhs + rhs;
+    return sum < lhs ? std::numeric_limits<distance_type>::max() : sum;
+}
+
+/**
+ * @brief Relaxes one tile over all intermediate vertices of one block, i.e.,
+ *      for i, j, k in [0, floyd_warshall_block_size),
+ *      c[i][j] = min(c[i][j], a[i][k] + b[k][j])
+ *      k is the outermost loop, so a and b may alias c (which happens in the first two phases)
+ * @param stride The number of elements between two rows of the matrix
+ */
+inline void min_plus_block_scalar(distance_type *c, const distance_type *a, const distance_type *b, std::size_t stride) {
+    constexpr auto unreachable = std::numeric_limits<distance_type>::max();
+
+    for (std::size_t k = 0; k < floyd_warshall_block_size; k++) {
+        const auto *b_row = b + k * stride;
+
+        for (std::size_t i = 0; i < floyd_warshall_block_size; i++) {
+            const auto a_ik = a[i * stride + k];
+            if (a_ik == unreachable) {
+                continue;
+            }
+
+            auto *c_row = c + i * stride;
+            for (std::size_t j = 0; j < floyd_warshall_block_size; j++) {
+                c_row[j] = std::min(c_row[j], saturating_add(a_ik, b_row[j]));
+            }
+        }
+    }
+}
+
+#ifdef APSP_HAS_X86_SIMD
+
+static_assert(sizeof(distance_type) == 4, "the AVX2 kernel works on 8 unsigned 32-bit lanes");
+
+__attribute__((target("avx2")))
+inline void min_plus_block_avx2(distance_type *c, const distance_type *a, const distance_type *b, std::size_t stride) {
+    constexpr auto unreachable = std::numeric_limits<distance_type>::max();
+    constexpr std::size_t lanes = 8;
+
+    const auto all_ones = _mm256_set1_epi32(-1);
+
+    for (std::size_t k = 0; k < floyd_warshall_block_size; k++) {
+        const auto *b_row = b + k * stride;
+
+        for (std::size_t i = 0; i < floyd_warshall_block_size; i++) {
+            const auto a_ik = a[i * stride + k];
+            if (a_ik == unreachable) {
+                continue;
+            }
+
+            const auto a_vector = _mm256_set1_epi32(static_cast<int>(a_ik));
+            auto *c_row = c + i * stride;
+
+            for (std::size_t j = 0; j < floyd_warshall_block_size; j += lanes) {
+                const auto b_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b_row + j));
+                const auto c_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c_row + j));
+
+                // the unsigned sum overflowed iff it is smaller than a_ik, then it is saturated to all ones
+                const auto sum = _mm256_add_epi32(a_vector, b_vector);
+                const auto no_overflow = _mm256_cmpeq_epi32(_mm256_max_epu32(sum, a_vector), sum);
+                const auto saturated_sum = _mm256_or_si256(sum, _mm256_xor_si256(no_overflow, all_ones));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(c_row + j), _mm256_min_epu32(c_vector, saturated_sum));
+            }
+        }
+    }
+}
+
+#endif
+
+using min_plus_block_function = void (*)(distance_type *, const distance_type *, const distance_type *, std::size_t);
+
+/**
+ * @brief Selects the AVX2 kernel if the CPU supports it, otherwise the scalar one
+ */
+inline min_plus_block_function select_min_plus_block() {
+#ifdef APSP_HAS_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        return min_plus_block_avx2;
+    }
+#endif
+    return min_plus_block_scalar;
+}
+
+/**
+ * @brief Calculates the all-pairs shortest-paths with a cache-blocked Floyd-Warshall algorithm.
+ *      The matrix is padded to a multiple of floyd_warshall_block_size and processed block by block in three phases:
+ *      (1) the diagonal tile, (2) the tiles in its row and column, (3) all other tiles,
+ *      the tiles of phases (2) and (3) are processed in parallel
+ * @param connectivity The adjacency list of the graph, either as maps or in CSR layout
+ * @return For all pairs for vertices i, j, the shortest path between them, i.e.,
+ *		<return>[i * number_vertices + j] = k
+ *		indicates that the shortest path i--->j has distance k,
+ *		or std::numeric_limits<distance_type>::max() if j is unreachable from i
+ */
+template<typename Graph>
+std::vector<distance_type> all_pairs_shortest_paths_floyd_warshall(const Graph &connectivity) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+    constexpr auto unreachable = std::numeric_limits<distance_type>::max();
+    constexpr auto block_size = floyd_warshall_block_size;
+
+    const auto number_vertices = connectivity.size();
+    const auto number_blocks = (number_vertices + block_size - 1) / block_size;
+    const auto stride = number_blocks * block_size;
+
+    std::vector<distance_type> padded_distances(stride * stride, unreachable);
+
+    for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+        const auto offset = source_vertex_id * stride;
+
+        for_each_neighbor(connectivity, source_vertex_id, [&](vertex_type target_vertex_id, distance_type edge_weight) {
+            auto &distance = padded_distances[offset + target_vertex_id];
+            distance = std::min(distance, edge_weight);
+        });
+    }
+
+    for (std::size_t vertex_id = 0; vertex_id < stride; vertex_id++) {
+        padded_distances[vertex_id * stride + vertex_id] = 0;
+    }
+
+    const auto min_plus_block = select_min_plus_block();
+    const auto tile = [&padded_distances, stride](std::size_t block_row, std::size_t block_column) {
+        return padded_distances.data() + block_row * block_size * stride + block_column * block_size;
+    };
+
+    std::vector<std::size_t> block_indices(number_blocks);
+    std::iota(block_indices.begin(), block_indices.end(), std::size_t(0));
+
+    std::vector<std::size_t> tile_indices(number_blocks * number_blocks);
+    std::iota(tile_indices.begin(), tile_indices.end(), std::size_t(0));
+
+    for (std::size_t k_block = 0; k_block < number_blocks; k_block++) {
+        auto *diagonal = tile(k_block, k_block);
+        min_plus_block(diagonal, diagonal, diagonal, stride);
+
+        parallel_for_each_source(block_indices, [&tile, &min_plus_block, diagonal, k_block, stride](vertex_type block_id) {
+            const auto block = static_cast<std::size_t>(block_id);
+            if (block == k_block) {
+                return;
+            }
+
+            auto *row_tile = tile(k_block, block);
+            min_plus_block(row_tile, diagonal, row_tile, stride);
+
+            auto *column_tile = tile(block, k_block);
+            min_plus_block(column_tile, column_tile, diagonal, stride);
+        });
+
+        parallel_for_each_source(tile_indices, [&tile, &min_plus_block, k_block, number_blocks, stride](vertex_type tile_id) {
+            const auto block_row = static_cast<std::size_t>(tile_id) / number_blocks;
+            const auto block_column = static_cast<std::size_t>(tile_id) % number_blocks;
+
+            if (block_row == k_block || block_column == k_block) {
+                return;
+            }
+
+            min_plus_block(tile(block_row, block_column), tile(block_row, k_block), tile(k_block, block_column), stride);
+        });
+    }
+
+    if (stride == number_vertices) {
+        return padded_distances;
+    }
+
+    std::vector<distance_type> all_distances(number_vertices * number_vertices);
+    for (std::size_t source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+        std::copy_n(padded_distances.begin() + source_vertex_id * stride, number_vertices,
+                    all_distances.begin() + source_vertex_id * number_vertices);
+    }
+
+    return all_distances;
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "graph.h"
+#include "graph_generator.h"
+#include "graph_io.h"
+
+/**
+ * Generates a synthetic graph (see graph_generator.h) in the text format, or in the binary graph format
+ * if the output ends with .bin:
+ *      04_exercise_generate_graph [--shape rmat|grid|erdos_renyi|power_law] [--vertices N] [--degree D]
+ *                                 [--weights uniform|constant|exponential] [--min-weight W] [--max-weight W]
+ *                                 [--seed S] [--threads T] <output>
+ */
+int main(int argc, char **argv) {
+    GraphGeneratorOptions options{};
+    unsigned int number_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::filesystem::path output_path{};
+
+    try {
+        for (int argument_id = 1; argument_id < argc; argument_id++) {
+            const std::string argument = argv[argument_id];
+
+            if (!argument.starts_with("--")) {
+                output_path = argument;
+                continue;
+            }
+            if (argument_id + 1 >= argc) {
+                throw std::invalid_argument(argument + " needs a value");
+            }
+            const std::string value = argv[++argument_id];
+
+            if (argument == "--shape") {
+                options.shape = parse_graph_shape(value);
+            } else if (argument == "--vertices") {
+                options.number_vertices = static_cast<vertex_type>(std::stol(value));
+            } else if (argument == "--degree") {
+                options.average_degree = std::stod(value);
+            } else if (argument == "--weights") {
+                options.weight_distribution = parse_weight_distribution(value);
+            } else if (argument == "--min-weight") {
+                options.minimum_weight = static_cast<distance_type>(std::stoul(value));
+            } else if (argument == "--max-weight") {
+                options.maximum_weight = static_cast<distance_type>(std::stoul(value));
+            } else if (argument == "--seed") {
+                options.seed = std::stoull(value);
+            } else if (argument == "--threads") {
+                number_threads = std::max(static_cast<unsigned int>(std::stoul(value)), 1u);
+            } else {
+                throw std::invalid_argument("unknown option " + argument);
+            }
+        }
+
+        if (output_path.empty()) {
+            std::cerr << "Usage: " << argv[0] << " [--shape rmat|grid|erdos_renyi|power_law] [--vertices N] [--degree D]\n"
+                      << "       [--weights uniform|constant|exponential] [--min-weight W] [--max-weight W]\n"
+                      << "       [--seed S] [--threads T] <output graph.txt or graph.bin>\n";
+            return 1;
+        }
+
+        const auto before_generating = std::chrono::high_resolution_clock::now();
+        const auto graph = generate_graph(options, number_threads);
+        const auto after_generating = std::chrono::high_resolution_clock::now();
+
+        if (output_path.extension() == ".bin") {
+            write_binary_graph(output_path, make_csr_graph(graph.number_vertices, graph.edges));
+        } else {
+            write_edge_list(output_path, graph, number_threads);
+        }
+        const auto after_writing = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Generated " << graph.number_vertices << " vertices and " << graph.edges.size() << " edges with "
+                  << number_threads << " threads in " << (after_generating - before_generating).count() << " ns.\n";
+        std::cout << "Wrote " << output_path.string() << " in " << (after_writing - after_generating).count() << " ns.\n";
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
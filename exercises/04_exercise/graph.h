@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using vertex_type = int;
+using distance_type = unsigned int;
+
+struct VertexDistancePair {
+    vertex_type vertex_index;
+    distance_type distance;
+};
+
+template<>
+struct std::greater<VertexDistancePair> {
+    bool operator()(const VertexDistancePair &lhs, const VertexDistancePair &rhs) const {
+        return lhs.distance > rhs.distance;
+    }
+};
+
+using adjacency_list_type = std::vector<std::map<vertex_type, distance_type>>;
+
+struct Edge {
+    vertex_type source_index;
+    vertex_type target_index;
+    distance_type weight;
+};
+
+/**
+ * @brief A graph in compressed sparse row layout. The outgoing edges of vertex i are stored contiguously, i.e.,
+ *      for e in [offsets[i], offsets[i + 1]), there is an edge i--->targets[e] with the weight weights[e]
+ *      and the targets of each vertex are sorted ascending.
+ *      The graph is an immutable view, storage keeps the arrays alive (heap buffers or a memory-mapped file),
+ *      so copies are cheap and share the arrays
+ * @tparam Vertex The integer type of the vertex indices
+ * @tparam Distance The unsigned integer type of the weights, and of the distances calculated on the graph,
+ *      its maximum is the distance of unreachable vertices, see narrow_types.h for narrower ones than distance_type
+ */
+template<typename Vertex, typename Distance>
+struct BasicCsrGraph {
+    using vertex_value_type = Vertex;
+    using distance_value_type = Distance;
+
+    std::span<const std::uint64_t> offsets{};
+    std::span<const Vertex> targets{};
+    std::span<const Distance> weights{};
+
+    std::shared_ptr<const void> storage{};
+
+    Distance minimum_weight = 0;
+    Distance maximum_weight = 0;
+
+    std::size_t size() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    std::size_t number_edges() const {
+        return targets.size();
+    }
+
+    std::span<const Vertex> neighbors(vertex_type vertex_id) const {
+        return targets.subspan(offsets[vertex_id], offsets[vertex_id + 1] - offsets[vertex_id]);
+    }
+
+    std::span<const Distance> neighbor_weights(vertex_type vertex_id) const {
+        return weights.subspan(offsets[vertex_id], offsets[vertex_id + 1] - offsets[vertex_id]);
+    }
+};
+
+using CsrGraph = BasicCsrGraph<vertex_type, distance_type>;
+
+/**
+ * @brief Sets the minimum and maximum edge weight of the graph from its weights array
+ */
+template<typename Vertex, typename Distance>
+void update_weight_range(BasicCsrGraph<Vertex, Distance> &graph) {
+    if (graph.weights.empty()) {
+        graph.minimum_weight = 0;
+        graph.maximum_weight = 0;
+        return;
+    }
+
+    const auto [minimum, maximum] = std::minmax_element(graph.weights.begin(), graph.weights.end());
+    graph.minimum_weight = *minimum;
+    graph.maximum_weight = *maximum;
+}
+
+/**
+ * @brief Builds a CSR graph that owns the specified arrays
+ * @param offsets The edge offsets, offsets.size() is the number of vertices + 1
+ * @param targets The target of each edge
+ * @param weights The weight of each edge
+ */
+template<typename Vertex, typename Distance>
+BasicCsrGraph<Vertex, Distance> make_csr_graph(std::vector<std::uint64_t> offsets, std::vector<Vertex> targets,
+                                               std::vector<Distance> weights) {
+    struct Buffers {
+        std::vector<std::uint64_t> offsets;
+        std::vector<Vertex> targets;
+        std::vector<Distance> weights;
+    };
+
+    if (offsets.empty()) {
+        offsets.push_back(0);
+    }
+
+    auto buffers = std::make_shared<const Buffers>(std::move(offsets), std::move(targets), std::move(weights));
+
+    BasicCsrGraph<Vertex, Distance> graph{buffers->offsets, buffers->targets, buffers->weights, buffers};
+    update_weight_range(graph);
+
+    return graph;
+}
+
+/**
+ * @brief Calls function(target_index, weight) for every outgoing edge of the specified vertex
+ */
+template<typename Function>
+void for_each_neighbor(const adjacency_list_type &connectivity, vertex_type vertex_id, Function &&function) {
+    for (const auto&[target_vertex_id, edge_weight]: connectivity[vertex_id]) {
+        function(target_vertex_id, edge_weight);
+    }
+}
+
+template<typename Vertex, typename Distance, typename Function>
+void for_each_neighbor(const BasicCsrGraph<Vertex, Distance> &graph, vertex_type vertex_id, Function &&function) {
+    const auto begin = graph.offsets[vertex_id];
+    const auto end = graph.offsets[vertex_id + 1];
+
+    for (auto edge_id = begin; edge_id < end; edge_id++) {
+        function(graph.targets[edge_id], graph.weights[edge_id]);
+    }
+}
+
+/**
+ * @brief Returns the largest edge weight of the graph, or 0 if it has no edges
+ */
+inline distance_type maximum_edge_weight(const adjacency_list_type &connectivity) {
+    distance_type maximum_weight = 0;
+
+    for (const auto &edges: connectivity) {
+        for (const auto&[target_vertex_id, edge_weight]: edges) {
+            maximum_weight = std::max(maximum_weight, edge_weight);
+        }
+    }
+
+    return maximum_weight;
+}
+
+template<typename Vertex, typename Distance>
+Distance maximum_edge_weight(const BasicCsrGraph<Vertex, Distance> &graph) {
+    return graph.maximum_weight;
+}
+
+/**
+ * @brief Returns the number of outgoing edges of the specified vertex
+ */
+inline std::size_t out_degree(const adjacency_list_type &connectivity, vertex_type vertex_id) {
+    return connectivity[vertex_id].size();
+}
+
+template<typename Vertex, typename Distance>
+std::size_t out_degree(const BasicCsrGraph<Vertex, Distance> &graph, vertex_type vertex_id) {
+    return graph.offsets[vertex_id + 1] - graph.offsets[vertex_id];
+}
+
+/**
+ * @brief The distance type of a graph, distance_type for adjacency lists of maps
+ */
+template<typename Graph>
+using graph_distance_t = std::remove_cvref_t<decltype(maximum_edge_weight(std::declval<const Graph &>()))>;
+
+/**
+ * @brief If the graph is a BasicCsrGraph of any vertex and distance types
+ */
+template<typename Graph>
+constexpr bool is_csr_graph_v = false;
+
+template<typename Vertex, typename Distance>
+constexpr bool is_csr_graph_v<BasicCsrGraph<Vertex, Distance>> = true;
+
+/**
+ * @return The distance as a distance_type, the unreachable marker of a narrower type stays the unreachable marker
+ */
+template<typename Distance>
+constexpr distance_type widen_distance(Distance distance) {
+    return distance == std::numeric_limits<Distance>::max() ? std::numeric_limits<distance_type>::max()
+                                                            : static_cast<distance_type>(distance);
+}
+
+/**
+ * @brief Builds a CSR graph from an unordered edge list. Edges whose indices are not in [0, number_vertices)
+ *      are skipped, and the weights of duplicate edges are added up
+ * @param number_vertices The number of vertices of the graph
+ * @param edges The edge list, it is sorted in place
+ * @return The graph in compressed sparse row layout
+ */
+inline CsrGraph make_csr_graph(vertex_type number_vertices, std::vector<Edge> edges) {
+    std::erase_if(edges, [number_vertices](const Edge &edge) {
+        return edge.source_index < 0 || edge.source_index >= number_vertices ||
+               edge.target_index < 0 || edge.target_index >= number_vertices;
+    });
+
+    std::sort(edges.begin(), edges.end(), [](const Edge &lhs, const Edge &rhs) {
+        if (lhs.source_index != rhs.source_index) {
+            return lhs.source_index < rhs.source_index;
+        }
+        return lhs.target_index < rhs.target_index;
+    });
+
+    std::vector<std::uint64_t> offsets(static_cast<std::size_t>(number_vertices) + 1, 0);
+    std::vector<vertex_type> targets{};
+    std::vector<distance_type> weights{};
+    targets.reserve(edges.size());
+    weights.reserve(edges.size());
+
+    for (std::size_t edge_id = 0; edge_id < edges.size(); edge_id++) {
+        const auto &edge = edges[edge_id];
+
+        if (edge_id > 0 && edges[edge_id - 1].source_index == edge.source_index &&
+            edges[edge_id - 1].target_index == edge.target_index) {
+            weights.back() += edge.weight;
+            continue;
+        }
+
+        targets.push_back(edge.target_index);
+        weights.push_back(edge.weight);
+        offsets[edge.source_index + 1]++;
+    }
+
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        offsets[vertex_id + 1] += offsets[vertex_id];
+    }
+
+    return make_csr_graph(std::move(offsets), std::move(targets), std::move(weights));
+}
+
+/**
+ * @brief Converts an adjacency list of maps into the compressed sparse row layout
+ */
+inline CsrGraph make_csr_graph(const adjacency_list_type &connectivity) {
+    const auto number_vertices = static_cast<vertex_type>(connectivity.size());
+
+    std::vector<std::uint64_t> offsets{0};
+    std::vector<vertex_type> targets{};
+    std::vector<distance_type> weights{};
+    offsets.reserve(connectivity.size() + 1);
+
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        for (const auto&[target_vertex_id, edge_weight]: connectivity[vertex_id]) {
+            targets.push_back(target_vertex_id);
+            weights.push_back(edge_weight);
+        }
+        offsets.push_back(targets.size());
+    }
+
+    return make_csr_graph(std::move(offsets), std::move(targets), std::move(weights));
+}
+
+/**
+ * @brief Converts a CSR graph into an adjacency list of maps
+ */
+inline adjacency_list_type make_adjacency_list(const CsrGraph &graph) {
+    const auto number_vertices = static_cast<vertex_type>(graph.size());
+
+    adjacency_list_type connectivity(number_vertices);
+
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        for_each_neighbor(graph, vertex_id, [&](vertex_type target_vertex_id, distance_type edge_weight) {
+            connectivity[vertex_id].emplace_hint(connectivity[vertex_id].end(), target_vertex_id, edge_weight);
+        });
+    }
+
+    return connectivity;
+}
+
+/**
+ * @brief Reverses all edges of the graph, i.e., the neighbors of vertex i in the result are the vertices with an edge to i
+ */
+template<typename Vertex, typename Distance>
+BasicCsrGraph<Vertex, Distance> transpose_graph(const BasicCsrGraph<Vertex, Distance> &graph) {
+    const auto number_vertices = graph.size();
+
+    std::vector<std::uint64_t> offsets(number_vertices + 1, 0);
+    for (const auto target_vertex_id: graph.targets) {
+        offsets[target_vertex_id + 1]++;
+    }
+    for (std::size_t vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        offsets[vertex_id + 1] += offsets[vertex_id];
+    }
+
+    std::vector<Vertex> targets(graph.number_edges());
+    std::vector<Distance> weights(graph.number_edges());
+    std::vector<std::uint64_t> positions(offsets.begin(), offsets.end() - 1);
+
+    // sources are visited in ascending order, so the reversed targets of each vertex are sorted as well
+    for (vertex_type source_vertex_id = 0; source_vertex_id < static_cast<vertex_type>(number_vertices); source_vertex_id++) {
+        for_each_neighbor(graph, source_vertex_id, [&](vertex_type target_vertex_id, Distance edge_weight) {
+            const auto position = positions[target_vertex_id]++;
+            targets[position] = static_cast<Vertex>(source_vertex_id);
+            weights[position] = edge_weight;
+        });
+    }
+
+    return make_csr_graph(std::move(offsets), std::move(targets), std::move(weights));
+}
+
+/**
+ * @brief Checks if all edges of the graph have the same weight, then the shortest paths are BFS levels times that weight
+ */
+template<typename Vertex, typename Distance>
+bool has_uniform_weights(const BasicCsrGraph<Vertex, Distance> &graph) {
+    return graph.minimum_weight == graph.maximum_weight;
+}
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "graph_io.h"
+
+/*
+ * Synthetic directed graphs for scaling studies. The edges are generated in fixed-size chunks, and every chunk has
+ * its own random generator seeded from (seed, chunk), so the threads share nothing and the graph only depends on the
+ * options, not on the number of threads.
+ *      rmat          R-MAT / Kronecker (Chakrabarti et al.), every edge descends into one of the four quadrants of
+ *                    the adjacency matrix per level, skewed degrees and communities like social or web graphs
+ *      grid          2D grid, every vertex has edges to its (up to) four neighbors, road-network-like with a
+ *                    large diameter, the average degree is ignored
+ *      erdos_renyi   G(n, m) with m = number_vertices * average_degree uniformly random edges
+ *      power_law     Chung-Lu graph, the expected degree of the i-th vertex is proportional to (i + 1)^(-1 / (exponent - 1))
+ * Self-loops are never generated, duplicate edges are (they are summed when the graph is read, see make_csr_graph),
+ * except with constant weights, where they are removed so the summed weights do not break the uniform weights.
+ */
+
+enum class GraphShape {
+    rmat,
+    grid,
+    erdos_renyi,
+    power_law,
+};
+
+/*
+ *      uniform       uniformly distributed in [minimum_weight, maximum_weight]
+ *      constant      all edges have minimum_weight, so the APSP engines use BFS instead of Dijkstra. Duplicate edges
+ *                    are removed, so there may be fewer than number_vertices * average_degree edges
+ *      exponential   minimum_weight plus an exponentially distributed part with mean (maximum_weight - minimum_weight) / 4,
+ *                    capped at maximum_weight, i.e., mostly light edges and a few heavy ones
+ */
+enum class WeightDistribution {
+    uniform,
+    constant,
+    exponential,
+};
+
+struct GraphGeneratorOptions {
+    GraphShape shape = GraphShape::rmat;
+    vertex_type number_vertices = 1 << 16;
+    double average_degree = 16;
+    WeightDistribution weight_distribution = WeightDistribution::uniform;
+    distance_type minimum_weight = 1;
+    distance_type maximum_weight = 100;
+    std::uint64_t seed = 1;
+    // the quadrant probabilities of R-MAT, d = 1 - a - b - c (the Graph500 defaults)
+    double rmat_a = 0.57;
+    double rmat_b = 0.19;
+    double rmat_c = 0.19;
+    // the exponent of the degree distribution of power_law
+    double power_law_exponent = 2.5;
+};
+
+inline GraphShape parse_graph_shape(const std::string &name) {
+    if (name == "rmat") {
+        return GraphShape::rmat;
+    }
+    if (name == "grid") {
+        return GraphShape::grid;
+    }
+    if (name == "erdos_renyi") {
+        return GraphShape::erdos_renyi;
+    }
+    if (name == "power_law") {
+        return GraphShape::power_law;
+    }
+    throw std::invalid_argument("unknown graph shape " + name);
+}
+
+inline WeightDistribution parse_weight_distribution(const std::string &name) {
+    if (name == "uniform") {
+        return WeightDistribution::uniform;
+    }
+    if (name == "constant") {
+        return WeightDistribution::constant;
+    }
+    if (name == "exponential") {
+        return WeightDistribution::exponential;
+    }
+    throw std::invalid_argument("unknown weight distribution " + name);
+}
+
+/**
+ * @brief The SplitMix64 finalizer, turns (seed, chunk) into well-separated seeds for the per-chunk generators
+ */
+inline std::uint64_t mix_seed(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Runs function(chunk_id) for chunk_id in [0, number_chunks) on number_threads threads
+ */
+template<typename Function>
+void parallel_for_each_chunk(std::size_t number_chunks, unsigned int number_threads, Function &&function) {
+    number_threads = std::max(1u, std::min<unsigned int>(number_threads, static_cast<unsigned int>(std::max<std::size_t>(number_chunks, 1))));
+
+    const auto worker = [&](unsigned int thread_id) {
+        for (auto chunk_id = static_cast<std::size_t>(thread_id); chunk_id < number_chunks; chunk_id += number_threads) {
+            function(chunk_id);
+        }
+    };
+
+    std::vector<std::thread> threads{};
+    for (unsigned int thread_id = 1; thread_id < number_threads; thread_id++) {
+        threads.emplace_back(worker, thread_id);
+    }
+    worker(0);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Generates a graph
+ * @param options The shape, size, weights and seed of the graph
+ * @param number_threads The number of generator threads, the result does not depend on it
+ * @return The number of vertices and the edges
+ */
+inline EdgeList generate_graph(const GraphGeneratorOptions &options,
+                               unsigned int number_threads = std::thread::hardware_concurrency()) {
+    static constexpr std::size_t chunk_size = 1 << 16;
+
+    const auto number_vertices = options.number_vertices;
+    if (number_vertices < 2) {
+        throw std::invalid_argument("a generated graph needs at least two vertices");
+    }
+    if (options.minimum_weight > options.maximum_weight) {
+        throw std::invalid_argument("the minimum weight is larger than the maximum weight");
+    }
+
+    // the grid is laid out row by row with grid_width columns, the last row may be incomplete
+    const auto grid_width = static_cast<vertex_type>(std::ceil(std::sqrt(static_cast<double>(number_vertices))));
+
+    const auto number_edges = options.shape == GraphShape::grid
+                              ? static_cast<std::size_t>(number_vertices) * 4
+                              : static_cast<std::size_t>(std::llround(number_vertices * options.average_degree));
+    const auto number_chunks = (number_edges + chunk_size - 1) / chunk_size;
+
+    // R-MAT descends scale levels, vertices beyond number_vertices are drawn again
+    const auto scale = static_cast<unsigned int>(std::bit_width(static_cast<std::uint64_t>(number_vertices - 1)));
+
+    // Chung-Lu samples both endpoints proportionally to the expected degrees, with an alias table (Vose)
+    // that is O(1) per sample instead of a binary search over the cumulative degrees
+    std::vector<double> alias_probabilities{};
+    std::vector<vertex_type> aliases{};
+    if (options.shape == GraphShape::power_law) {
+        if (options.power_law_exponent <= 1.0) {
+            throw std::invalid_argument("the power-law exponent must be larger than 1");
+        }
+
+        const auto degree_exponent = -1.0 / (options.power_law_exponent - 1.0);
+        alias_probabilities.resize(number_vertices);
+        aliases.resize(number_vertices);
+
+        double sum = 0;
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            alias_probabilities[vertex_id] = std::pow(static_cast<double>(vertex_id) + 1.0, degree_exponent);
+            sum += alias_probabilities[vertex_id];
+        }
+
+        std::vector<vertex_type> small{};
+        std::vector<vertex_type> large{};
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            aliases[vertex_id] = vertex_id;
+            alias_probabilities[vertex_id] *= number_vertices / sum;
+            (alias_probabilities[vertex_id] < 1.0 ? small : large).push_back(vertex_id);
+        }
+
+        while (!small.empty() && !large.empty()) {
+            const auto small_id = small.back();
+            const auto large_id = large.back();
+            small.pop_back();
+
+            aliases[small_id] = large_id;
+            alias_probabilities[large_id] -= 1.0 - alias_probabilities[small_id];
+
+            if (alias_probabilities[large_id] < 1.0) {
+                large.pop_back();
+                small.push_back(large_id);
+            }
+        }
+    }
+
+    // R-MAT concentrates the edges on the small indices, a random relabeling spreads the hubs over the graph
+    std::vector<vertex_type> relabeling{};
+    if (options.shape == GraphShape::rmat) {
+        relabeling.resize(number_vertices);
+        std::iota(relabeling.begin(), relabeling.end(), vertex_type(0));
+        std::mt19937_64 generator(mix_seed(options.seed));
+        std::shuffle(relabeling.begin(), relabeling.end(), generator);
+    }
+
+    std::vector<Edge> edges(number_edges);
+
+    parallel_for_each_chunk(number_chunks, number_threads, [&](std::size_t chunk_id) {
+        std::mt19937_64 generator(mix_seed(options.seed ^ mix_seed(chunk_id + 1)));
+        std::uniform_real_distribution<double> probability(0.0, 1.0);
+        std::uniform_int_distribution<vertex_type> vertex_distribution(0, number_vertices - 1);
+        std::uniform_int_distribution<distance_type> uniform_weight(options.minimum_weight, options.maximum_weight);
+        std::exponential_distribution<double> exponential_weight(
+                4.0 / std::max(1.0, static_cast<double>(options.maximum_weight - options.minimum_weight)));
+
+        const auto draw_weight = [&]() -> distance_type {
+            switch (options.weight_distribution) {
+                case WeightDistribution::constant:
+                    return options.minimum_weight;
+                case WeightDistribution::exponential:
+                    return static_cast<distance_type>(std::min<double>(
+                            options.maximum_weight, options.minimum_weight + std::floor(exponential_weight(generator))));
+                default:
+                    return uniform_weight(generator);
+            }
+        };
+
+        // every level needs one quadrant draw, 16 random bits are precise enough, so one 64-bit number serves 4 levels
+        const auto threshold_a = static_cast<std::uint64_t>(options.rmat_a * 65536.0);
+        const auto threshold_b = static_cast<std::uint64_t>((options.rmat_a + options.rmat_b) * 65536.0);
+        const auto threshold_c = static_cast<std::uint64_t>((options.rmat_a + options.rmat_b + options.rmat_c) * 65536.0);
+
+        const auto draw_rmat_vertex_pair = [&]() {
+            while (true) {
+                std::uint64_t source = 0;
+                std::uint64_t target = 0;
+                std::uint64_t random_bits = 0;
+
+                for (unsigned int level = 0; level < scale; level++) {
+                    if (level % 4 == 0) {
+                        random_bits = generator();
+                    }
+                    const auto p = random_bits & 0xffff;
+                    random_bits >>= 16;
+
+                    // quadrant a is (0, 0), b is (0, 1), c is (1, 0) and d is (1, 1)
+                    const auto down = p >= threshold_b;
+                    const auto right = (p >= threshold_a && p < threshold_b) || p >= threshold_c;
+                    source = (source << 1) | (down ? 1 : 0);
+                    target = (target << 1) | (right ? 1 : 0);
+                }
+                if (source < static_cast<std::uint64_t>(number_vertices) && target < static_cast<std::uint64_t>(number_vertices)) {
+                    return std::make_pair(relabeling[source], relabeling[target]);
+                }
+            }
+        };
+
+        const auto draw_power_law_vertex = [&]() {
+            const auto vertex_id = vertex_distribution(generator);
+            return probability(generator) < alias_probabilities[vertex_id] ? vertex_id : aliases[vertex_id];
+        };
+
+        const auto first_edge_id = chunk_id * chunk_size;
+        const auto last_edge_id = std::min(first_edge_id + chunk_size, number_edges);
+
+        for (auto edge_id = first_edge_id; edge_id < last_edge_id; edge_id++) {
+            auto &edge = edges[edge_id];
+
+            if (options.shape == GraphShape::grid) {
+                // edge 4 * v + direction leads to the right, left, lower or upper neighbor of v, if there is one
+                const auto vertex_id = static_cast<vertex_type>(edge_id / 4);
+                const auto row = vertex_id / grid_width;
+                const auto column = vertex_id % grid_width;
+
+                vertex_type neighbor_id = -1;
+                switch (edge_id % 4) {
+                    case 0:
+                        neighbor_id = column + 1 < grid_width ? vertex_id + 1 : -1;
+                        break;
+                    case 1:
+                        neighbor_id = column > 0 ? vertex_id - 1 : -1;
+                        break;
+                    case 2:
+                        neighbor_id = vertex_id + grid_width;
+                        break;
+                    default:
+                        neighbor_id = row > 0 ? vertex_id - grid_width : -1;
+                        break;
+                }
+
+                // missing neighbors at the border become invalid edges, which are removed below
+                edge = {vertex_id, neighbor_id >= 0 && neighbor_id < number_vertices ? neighbor_id : vertex_id, draw_weight()};
+                continue;
+            }
+
+            do {
+                if (options.shape == GraphShape::rmat) {
+                    std::tie(edge.source_index, edge.target_index) = draw_rmat_vertex_pair();
+                } else if (options.shape == GraphShape::power_law) {
+                    edge.source_index = draw_power_law_vertex();
+                    edge.target_index = draw_power_law_vertex();
+                } else {
+                    edge.source_index = vertex_distribution(generator);
+                    edge.target_index = vertex_distribution(generator);
+                }
+            } while (edge.source_index == edge.target_index);
+
+            edge.weight = draw_weight();
+        }
+    });
+
+    if (options.shape == GraphShape::grid) {
+        std::erase_if(edges, [](const Edge &edge) { return edge.source_index == edge.target_index; });
+    }
+
+    if (options.weight_distribution == WeightDistribution::constant) {
+        const auto vertex_pair = [](const Edge &edge) {
+            return std::make_pair(edge.source_index, edge.target_index);
+        };
+
+        std::sort(edges.begin(), edges.end(), [&vertex_pair](const Edge &lhs, const Edge &rhs) {
+            return vertex_pair(lhs) < vertex_pair(rhs);
+        });
+        edges.erase(std::unique(edges.begin(), edges.end(), [&vertex_pair](const Edge &lhs, const Edge &rhs) {
+            return vertex_pair(lhs) == vertex_pair(rhs);
+        }), edges.end());
+    }
+
+    return {number_vertices, std::move(edges)};
+}
+
+/**
+ * @brief Writes the graph in the text format of read_connectivity. The lines are formatted in parallel,
+ *      one buffer per chunk of edges, and written in order
+ */
+inline void write_edge_list(const std::filesystem::path &path, const EdgeList &graph,
+                            unsigned int number_threads = std::thread::hardware_concurrency()) {
+    static constexpr std::size_t chunk_size = 1 << 16;
+    // three numbers of at most 10 digits, two separators and a newline
+    static constexpr std::size_t maximum_line_size = 3 * 11 + 1;
+
+    const auto number_chunks = (graph.edges.size() + chunk_size - 1) / chunk_size;
+    std::vector<std::string> buffers(number_chunks);
+
+    parallel_for_each_chunk(number_chunks, number_threads, [&](std::size_t chunk_id) {
+        const auto first_edge_id = chunk_id * chunk_size;
+        const auto last_edge_id = std::min(first_edge_id + chunk_size, graph.edges.size());
+
+        auto &buffer = buffers[chunk_id];
+        buffer.resize((last_edge_id - first_edge_id) * maximum_line_size);
+
+        char *position = buffer.data();
+        char *const end = buffer.data() + buffer.size();
+
+        for (auto edge_id = first_edge_id; edge_id < last_edge_id; edge_id++) {
+            const auto &edge = graph.edges[edge_id];
+            position = std::to_chars(position, end, edge.source_index).ptr;
+            *position++ = '\t';
+            position = std::to_chars(position, end, edge.target_index).ptr;
+            *position++ = '\t';
+            position = std::to_chars(position, end, edge.weight).ptr;
+            *position++ = '\n';
+        }
+
+        buffer.resize(position - buffer.data());
+    });
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("cannot create " + path.string());
+    }
+
+    file << graph.number_vertices << '\n';
+    for (const auto &buffer: buffers) {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    if (!file) {
+        throw std::runtime_error("cannot write " + path.string());
+    }
+}
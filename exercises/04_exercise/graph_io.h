@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "graph.h"
+#include "mapped_file.h"
+#include "perf_counters.h"
+
+struct EdgeList {
+    vertex_type number_vertices;
+    std::vector<Edge> edges;
+};
+
+struct ParseStatistics {
+    std::size_t number_bytes = 0;
+    std::size_t number_edges = 0;
+    unsigned int number_threads = 0;
+    double seconds = 0.0;
+
+    double megabytes_per_second() const {
+        return seconds > 0.0 ? static_cast<double>(number_bytes) / 1e6 / seconds : 0.0;
+    }
+};
+
+inline bool is_blank(char character) {
+    return character == ' ' || character == '\t' || character == '\r' || character == '\v' || character == '\f';
+}
+
+/**
+ * @brief Parses the next whitespace-separated number in [begin, end) into value
+ * @return The position after the number, or nullptr if there is no number
+ */
+template<typename T>
+const char *parse_number(const char *begin, const char *end, T &value) {
+    while (begin != end && is_blank(*begin)) {
+        begin++;
+    }
+
+    const auto [position, error] = std::from_chars(begin, end, value);
+    if (error != std::errc{}) {
+        return nullptr;
+    }
+
+    return position;
+}
+
+/**
+ * @brief Parses all edge lines in [begin, end) and appends the edges with indices in [0, number_vertices),
+ *      lines that do not start with three numbers are skipped
+ */
+inline void parse_edge_lines(const char *begin, const char *end, vertex_type number_vertices, std::vector<Edge> &edges) {
+    while (begin != end) {
+        const auto *newline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+        const auto *line_end = newline == nullptr ? end : newline;
+
+        Edge edge{};
+        const char *position = begin;
+
+        const auto success =
+                (position = parse_number(position, line_end, edge.source_index)) != nullptr &&
+                (position = parse_number(position, line_end, edge.target_index)) != nullptr &&
+                parse_number(position, line_end, edge.weight) != nullptr;
+
+        if (success && edge.source_index >= 0 && edge.source_index < number_vertices &&
+            edge.target_index >= 0 && edge.target_index < number_vertices) {
+            edges.push_back(edge);
+        }
+
+        begin = newline == nullptr ? end : newline + 1;
+    }
+}
+
+/**
+ * @brief Reads the edges in the specified path. The file format must be:
+ *      number_vertices : size_t
+ *      (source_index : size_t, target_index : size_t, weight : unsigned int)*
+ *      lines that cannot be parsed and edges with indices not in [0, number_vertices) are skipped.
+ *      The file is mapped into memory and split into byte ranges that end on newlines,
+ *      each range is parsed on its own thread and the per-thread edges are concatenated in file order
+ * @param path The path to the file that specifies the connectivity
+ * @param number_threads The maximum number of parser threads, each thread gets at least 1 MiB
+ * @param statistics If not nullptr, receives the number of bytes and the parse throughput
+ * @return The number of vertices and all edges in the order of the file
+ */
+inline EdgeList read_edge_list(const std::filesystem::path &path,
+                               unsigned int number_threads = std::thread::hardware_concurrency(),
+                               ParseStatistics *statistics = nullptr) {
+    static constexpr std::size_t minimum_range_size = std::size_t(1) << 20;
+
+    const auto before_parsing = std::chrono::steady_clock::now();
+
+    const MappedFile mapped_file(path);
+    const auto bytes = mapped_file.bytes();
+    mapped_file.advise(MADV_SEQUENTIAL);
+
+    if (bytes.empty()) {
+        return {0, {}};
+    }
+
+    const auto *file_begin = reinterpret_cast<const char *>(bytes.data());
+    const auto *file_end = file_begin + bytes.size();
+
+    const auto *first_newline = static_cast<const char *>(std::memchr(file_begin, '\n', bytes.size()));
+    const auto *body_begin = first_newline == nullptr ? file_end : first_newline + 1;
+
+    vertex_type number_vertices = 0;
+    if (parse_number(file_begin, body_begin, number_vertices) == nullptr || number_vertices < 0) {
+        number_vertices = 0;
+    }
+
+    const auto body_size = static_cast<std::size_t>(file_end - body_begin);
+    const auto maximum_threads = std::max<std::size_t>(body_size / minimum_range_size, 1);
+    const auto number_ranges = static_cast<unsigned int>(std::clamp<std::size_t>(number_threads, 1, maximum_threads));
+
+    std::vector<const char *> range_begins(number_ranges + 1, file_end);
+    range_begins[0] = body_begin;
+
+    for (unsigned int range_id = 1; range_id < number_ranges; range_id++) {
+        const auto *nominal_begin = std::max(body_begin + body_size / number_ranges * range_id, range_begins[range_id - 1]);
+        const auto *newline = static_cast<const char *>(std::memchr(nominal_begin, '\n', file_end - nominal_begin));
+        range_begins[range_id] = newline == nullptr ? file_end : newline + 1;
+    }
+
+    std::vector<std::vector<Edge>> range_edges(number_ranges);
+
+    const auto parse_range = [&](unsigned int range_id) {
+        const auto *range_begin = range_begins[range_id];
+        const auto *range_end = range_begins[range_id + 1];
+
+        // roughly 10 bytes per edge line, reserving avoids most of the reallocations
+        range_edges[range_id].reserve(static_cast<std::size_t>(range_end - range_begin) / 10);
+        parse_edge_lines(range_begin, range_end, number_vertices, range_edges[range_id]);
+    };
+
+    std::vector<std::thread> threads{};
+    for (unsigned int range_id = 1; range_id < number_ranges; range_id++) {
+        threads.emplace_back(parse_range, range_id);
+    }
+    parse_range(0);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    std::vector<std::size_t> range_positions(number_ranges + 1, 0);
+    for (unsigned int range_id = 0; range_id < number_ranges; range_id++) {
+        range_positions[range_id + 1] = range_positions[range_id] + range_edges[range_id].size();
+    }
+
+    std::vector<Edge> edges(range_positions.back());
+
+    std::vector<unsigned int> range_ids(number_ranges);
+    std::iota(range_ids.begin(), range_ids.end(), 0u);
+    std::for_each(std::execution::par, range_ids.begin(), range_ids.end(), [&](unsigned int range_id) {
+        std::copy(range_edges[range_id].begin(), range_edges[range_id].end(), edges.begin() + range_positions[range_id]);
+    });
+
+    const auto after_parsing = std::chrono::steady_clock::now();
+
+    if (statistics != nullptr) {
+        statistics->number_bytes = bytes.size();
+        statistics->number_edges = edges.size();
+        statistics->number_threads = number_ranges;
+        statistics->seconds = std::chrono::duration<double>(after_parsing - before_parsing).count();
+    }
+
+    return {number_vertices, std::move(edges)};
+}
+
+/**
+ * @brief Reads the connectivity in the specified path. The file format must be:
+ *      number_vertices : size_t
+ *      (source_index : size_t, target_index : size_t, weight : unsigned int)*
+ *      and no index must be larger or equal to the number of vertices
+ * @param path The path to the file that specifies the connectivity
+ * @return The connectivity as an adjacency list, i.e.,
+ *      for vertices i, j, and the weight of their edge k,
+ *      <return>[i][j] = k
+ *      if <return>[i] does not contain j, then k == 0
+ */
+inline adjacency_list_type read_connectivity(const std::filesystem::path &path) {
+    const auto &[number_vertices, edges] = read_edge_list(path);
+
+    adjacency_list_type connectivity(number_vertices);
+
+    for (const auto &[source_idx, target_idx, weight]: edges) {
+        if (source_idx >= number_vertices || target_idx >= number_vertices) {
+            continue;
+        }
+
+        connectivity[source_idx][target_idx] += weight;
+    }
+
+    return connectivity;
+}
+
+/**
+ * @brief Reads the connectivity in the specified path (same format as read_connectivity)
+ *      into the compressed sparse row layout
+ * @param path The path to the file that specifies the connectivity
+ * @param statistics If not nullptr, receives the parse throughput
+ * @return The connectivity as a CSR graph, duplicate edges have their weights added up
+ */
+inline CsrGraph read_connectivity_csr(const std::filesystem::path &path, ParseStatistics *statistics = nullptr) {
+    auto [number_vertices, edges] = read_edge_list(path, std::thread::hardware_concurrency(), statistics);
+    return make_csr_graph(number_vertices, std::move(edges));
+}
+
+/**
+ * The binary graph format is the CSR layout written to disk as is, so that it can be mapped into memory
+ * and used without parsing. All values are little-endian, every section starts at a multiple of 64 bytes:
+ *      BinaryGraphHeader
+ *      offsets : uint64_t[number_vertices + 1]
+ *      targets : vertex_type[number_edges]
+ *      weights : distance_type[number_edges]
+ */
+constexpr std::array<char, 8> binary_graph_magic = {'A', 'P', 'S', 'P', 'C', 'S', 'R', '\0'};
+constexpr std::uint32_t binary_graph_version = 1;
+constexpr std::uint64_t binary_graph_alignment = 64;
+
+struct BinaryGraphHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint32_t vertex_size;
+    std::uint32_t distance_size;
+    std::uint64_t number_vertices;
+    std::uint64_t number_edges;
+    std::uint64_t offsets_position;
+    std::uint64_t targets_position;
+    std::uint64_t weights_position;
+    std::uint64_t file_size;
+};
+
+static_assert(std::endian::native == std::endian::little, "the binary graph format is little-endian");
+
+inline std::uint64_t align_binary_graph_position(std::uint64_t position) {
+    return (position + binary_graph_alignment - 1) / binary_graph_alignment * binary_graph_alignment;
+}
+
+/**
+ * @brief Writes the graph in the binary graph format
+ * @param path The path to the file that is created or overwritten
+ * @param graph The graph to write
+ */
+inline void write_binary_graph(const std::filesystem::path &path, const CsrGraph &graph) {
+    BinaryGraphHeader header{};
+    header.magic = binary_graph_magic;
+    header.version = binary_graph_version;
+    header.header_size = sizeof(BinaryGraphHeader);
+    header.vertex_size = sizeof(vertex_type);
+    header.distance_size = sizeof(distance_type);
+    header.number_vertices = graph.size();
+    header.number_edges = graph.number_edges();
+    header.offsets_position = align_binary_graph_position(sizeof(BinaryGraphHeader));
+    header.targets_position = align_binary_graph_position(header.offsets_position + graph.offsets.size_bytes());
+    header.weights_position = align_binary_graph_position(header.targets_position + graph.targets.size_bytes());
+    header.file_size = header.weights_position + graph.weights.size_bytes();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("cannot create " + path.string());
+    }
+
+    const auto write_section = [&file](std::uint64_t position, const void *data, std::size_t size) {
+        static constexpr std::array<char, binary_graph_alignment> padding{};
+        const auto current_position = static_cast<std::uint64_t>(file.tellp());
+        file.write(padding.data(), static_cast<std::streamsize>(position - current_position));
+        file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write_section(header.offsets_position, graph.offsets.data(), graph.offsets.size_bytes());
+    write_section(header.targets_position, graph.targets.data(), graph.targets.size_bytes());
+    write_section(header.weights_position, graph.weights.data(), graph.weights.size_bytes());
+
+    if (!file) {
+        throw std::runtime_error("cannot write " + path.string());
+    }
+}
+
+/**
+ * @brief Checks if the file at the specified path starts with the magic of the binary graph format
+ */
+inline bool is_binary_graph(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::array<char, 8> magic{};
+    file.read(magic.data(), magic.size());
+    return file && magic == binary_graph_magic;
+}
+
+/**
+ * @brief Maps a file in the binary graph format into memory. Nothing is parsed or copied,
+ *      the returned graph views the mapped pages directly and keeps the mapping alive
+ * @param path The path to the file in the binary graph format
+ * @return The graph in compressed sparse row layout
+ */
+inline CsrGraph map_binary_graph(const std::filesystem::path &path) {
+    auto mapped_file = std::make_shared<const MappedFile>(path);
+    const auto bytes = mapped_file->bytes();
+
+    BinaryGraphHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        throw std::runtime_error(path.string() + " is too small for a binary graph");
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    if (header.magic != binary_graph_magic) {
+        throw std::runtime_error(path.string() + " is not a binary graph");
+    }
+    if (header.version != binary_graph_version || header.header_size != sizeof(BinaryGraphHeader)) {
+        throw std::runtime_error(path.string() + " has an unsupported binary graph version");
+    }
+    if (header.vertex_size != sizeof(vertex_type) || header.distance_size != sizeof(distance_type)) {
+        throw std::runtime_error(path.string() + " was written with different vertex or distance types");
+    }
+
+    if (header.number_vertices > static_cast<std::uint64_t>(std::numeric_limits<vertex_type>::max())) {
+        throw std::runtime_error(path.string() + " has more vertices than vertex_type can index");
+    }
+
+    // a section of count elements fits into the file, without overflowing the size arithmetic
+    const auto section_fits = [file_size = static_cast<std::uint64_t>(bytes.size())](std::uint64_t position, std::uint64_t count,
+                                                                                     std::uint64_t element_size) {
+        return position % binary_graph_alignment == 0 && position <= file_size &&
+               count <= (file_size - position) / element_size;
+    };
+
+    if (header.file_size != bytes.size() ||
+        !section_fits(header.offsets_position, header.number_vertices + 1, sizeof(std::uint64_t)) ||
+        !section_fits(header.targets_position, header.number_edges, sizeof(vertex_type)) ||
+        !section_fits(header.weights_position, header.number_edges, sizeof(distance_type))) {
+        throw std::runtime_error(path.string() + " is truncated or corrupted");
+    }
+
+    const auto *base = bytes.data();
+
+    CsrGraph graph{};
+    graph.offsets = {reinterpret_cast<const std::uint64_t *>(base + header.offsets_position), header.number_vertices + 1};
+    graph.targets = {reinterpret_cast<const vertex_type *>(base + header.targets_position), header.number_edges};
+    graph.weights = {reinterpret_cast<const distance_type *>(base + header.weights_position), header.number_edges};
+    graph.storage = std::move(mapped_file);
+
+    // the arrays are used without bounds checks, so a corrupted file must not get past here, O(V + E) is cheap next to APSP
+    if (graph.offsets.front() != 0 || graph.offsets.back() != header.number_edges ||
+        !std::is_sorted(graph.offsets.begin(), graph.offsets.end())) {
+        throw std::runtime_error(path.string() + " has inconsistent edge offsets");
+    }
+    const auto number_vertices = static_cast<vertex_type>(header.number_vertices);
+    if (std::any_of(graph.targets.begin(), graph.targets.end(), [number_vertices](vertex_type target_vertex_id) {
+        return target_vertex_id < 0 || target_vertex_id >= number_vertices;
+    })) {
+        throw std::runtime_error(path.string() + " has edge targets out of range");
+    }
+
+    update_weight_range(graph);
+
+    return graph;
+}
+
+/**
+ * @brief Loads a graph in either the text format (see read_connectivity) or the binary graph format,
+ *      the format is detected by the magic at the start of the file
+ * @param statistics If not nullptr and the file is in the text format, receives the parse throughput
+ */
+inline CsrGraph load_graph(const std::filesystem::path &path, ParseStatistics *statistics = nullptr) {
+    const PerfStageScope stage_scope(PerfStage::graph_load);
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error(path.string() + " does not exist");
+    }
+
+    if (is_binary_graph(path)) {
+        return map_binary_graph(path);
+    }
+
+    return read_connectivity_csr(path, statistics);
+}
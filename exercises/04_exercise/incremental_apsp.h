@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "execution_backend.h"
+#include "floyd_warshall.h"
+#include "graph.h"
+
+/*
+ * Repairs an all-pairs shortest-paths matrix after edges were inserted or their weights decreased, instead of
+ * recalculating it. Distances can only shrink, and a pair x--->y improves through the new edge u--->v only if
+ * x--->u--->v improves x--->v and u--->v--->y improves u--->y. So it is enough to relax the pairs of
+ *      the affected sources S = {x : d(x, u) + w < d(x, v)}   (one column scan) and
+ *      the affected targets T = {y : w + d(v, y) < d(u, y)}   (one row scan),
+ * i.e., O(|S| * |T|) work per edge instead of one Dijkstra per vertex. Weight increases and deletions can make
+ * distances grow, which needs a recalculation of the affected rows, and are rejected.
+ */
+
+struct IncrementalUpdateStatistics {
+    std::size_t number_affected_sources = 0;
+    std::size_t number_affected_targets = 0;
+};
+
+/**
+ * @brief Updates the distance matrix after the edge edge.source_index--->edge.target_index got the weight edge.weight,
+ *      which must not be larger than its previous weight (if any)
+ * @param all_distances The distance matrix (same layout as all_pairs_shortest_paths), updated in place
+ * @param number_vertices The number of vertices
+ * @param edge The new or decreased edge
+ * @param affected_targets Receives the columns that may have changed
+ * @return The number of affected sources and targets
+ */
+inline IncrementalUpdateStatistics decrease_edge_all_pairs_shortest_paths(std::vector<distance_type> &all_distances,
+                                                                           vertex_type number_vertices, const Edge &edge,
+                                                                           std::vector<vertex_type> &affected_targets) {
+    if (edge.source_index < 0 || edge.source_index >= number_vertices ||
+        edge.target_index < 0 || edge.target_index >= number_vertices) {
+        throw std::out_of_range("the edge has a vertex outside of the graph");
+    }
+
+    affected_targets.clear();
+
+    const auto stride = static_cast<std::size_t>(number_vertices);
+    const auto source_row = static_cast<std::size_t>(edge.source_index) * stride;
+    const auto target_row = static_cast<std::size_t>(edge.target_index) * stride;
+
+    // row target_index and column source_index never change (they would need a negative cycle), so they can be read
+    // while the affected rows are relaxed in parallel
+    std::vector<std::size_t> affected_sources{};
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        const auto row = static_cast<std::size_t>(vertex_id) * stride;
+        if (saturating_add(all_distances[row + edge.source_index], edge.weight) < all_distances[row + edge.target_index]) {
+            affected_sources.push_back(vertex_id);
+        }
+    }
+
+    if (affected_sources.empty()) {
+        return {};
+    }
+
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        if (saturating_add(edge.weight, all_distances[target_row + vertex_id]) < all_distances[source_row + vertex_id]) {
+            affected_targets.push_back(vertex_id);
+        }
+    }
+
+    const auto relax_source = [&all_distances, &affected_targets, &edge, stride, target_row](vertex_type source_vertex_id) {
+        const auto row = static_cast<std::size_t>(source_vertex_id) * stride;
+        const auto distance_to_edge = saturating_add(all_distances[row + edge.source_index], edge.weight);
+
+        for (const auto target_vertex_id: affected_targets) {
+            auto &distance = all_distances[row + target_vertex_id];
+            distance = std::min(distance, saturating_add(distance_to_edge, all_distances[target_row + target_vertex_id]));
+        }
+    };
+    parallel_for_each_source(affected_sources, relax_source);
+
+    return {affected_sources.size(), affected_targets.size()};
+}
+
+/**
+ * @brief Recalculates the furthest reaching vertex of the given columns, same result as calculate_largest_smallest_path
+ */
+inline void update_furthest_reaching_vertex(std::span<const distance_type> all_distances, vertex_type number_vertices,
+                                            std::span<const vertex_type> columns,
+                                            std::vector<VertexDistancePair> &furthest_reaching_vertex) {
+    const std::vector<std::size_t> targets(columns.begin(), columns.end());
+
+    parallel_for_each_source(targets, [&all_distances, &furthest_reaching_vertex, number_vertices](vertex_type target_vertex_id) {
+        VertexDistancePair furthest = {target_vertex_id, 0};
+
+        for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+            const auto current_distance =
+                    all_distances[static_cast<std::size_t>(source_vertex_id) * number_vertices + target_vertex_id];
+            if (current_distance > furthest.distance) {
+                furthest = {source_vertex_id, current_distance};
+            }
+        }
+
+        furthest_reaching_vertex[target_vertex_id] = furthest;
+    });
+}
+
+/**
+ * @brief Inserts the edges into the graph (or decreases their weights) and repairs the distance matrix
+ *      and the furthest reaching vertices instead of recalculating them
+ * @param connectivity The adjacency list of the graph, updated in place
+ * @param all_distances The distance matrix of connectivity, updated in place
+ * @param furthest_reaching_vertex The furthest reaching vertices of all_distances, updated in place
+ * @param edges The new edges or new weights, an edge may not be heavier than the one it replaces
+ * @return The number of affected sources and targets summed over the edges
+ */
+inline IncrementalUpdateStatistics update_all_pairs_shortest_paths(adjacency_list_type &connectivity,
+                                                                   std::vector<distance_type> &all_distances,
+                                                                   std::vector<VertexDistancePair> &furthest_reaching_vertex,
+                                                                   std::span<const Edge> edges) {
+    const auto number_vertices = static_cast<vertex_type>(connectivity.size());
+
+    // validate all edges first, so a rejected batch leaves everything unchanged,
+    // an edge may also appear several times in the batch
+    std::map<std::pair<vertex_type, vertex_type>, distance_type> batch_weights{};
+    for (const auto &edge: edges) {
+        if (edge.source_index < 0 || edge.source_index >= number_vertices ||
+            edge.target_index < 0 || edge.target_index >= number_vertices) {
+            throw std::out_of_range("the edge has a vertex outside of the graph");
+        }
+
+        const auto key = std::make_pair(edge.source_index, edge.target_index);
+        const auto &neighbors = connectivity[edge.source_index];
+
+        if (const auto iterator = batch_weights.find(key); iterator != batch_weights.end()) {
+            if (iterator->second < edge.weight) {
+                throw std::invalid_argument("weight increases cannot be applied incrementally");
+            }
+        } else if (const auto neighbor = neighbors.find(edge.target_index);
+                neighbor != neighbors.end() && neighbor->second < edge.weight) {
+            throw std::invalid_argument("weight increases cannot be applied incrementally");
+        }
+
+        batch_weights[key] = edge.weight;
+    }
+
+    IncrementalUpdateStatistics statistics{};
+    std::vector<std::uint8_t> column_changed(number_vertices, 0);
+    std::vector<vertex_type> affected_targets{};
+
+    for (const auto &edge: edges) {
+        connectivity[edge.source_index][edge.target_index] = edge.weight;
+
+        const auto edge_statistics = decrease_edge_all_pairs_shortest_paths(all_distances, number_vertices, edge, affected_targets);
+        statistics.number_affected_sources += edge_statistics.number_affected_sources;
+        statistics.number_affected_targets += edge_statistics.number_affected_targets;
+
+        for (const auto target_vertex_id: affected_targets) {
+            column_changed[target_vertex_id] = 1;
+        }
+    }
+
+    std::vector<vertex_type> changed_columns{};
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        if (column_changed[vertex_id] != 0) {
+            changed_columns.push_back(vertex_id);
+        }
+    }
+
+    update_furthest_reaching_vertex(all_distances, number_vertices, changed_columns, furthest_reaching_vertex);
+
+    return statistics;
+}
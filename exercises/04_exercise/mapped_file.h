@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief A read-only, shared memory mapping of a whole file. All processes that map the same file share
+ *      one copy of its pages in the page cache. The mapping is released when the object is destroyed
+ */
+class MappedFile {
+    void *address = nullptr;
+    std::size_t size = 0;
+
+public:
+    explicit MappedFile(const std::filesystem::path &path) {
+        const auto file_descriptor = ::open(path.c_str(), O_RDONLY);
+        if (file_descriptor < 0) {
+            throw std::runtime_error("cannot open " + path.string());
+        }
+
+        struct stat file_status{};
+        if (::fstat(file_descriptor, &file_status) != 0) {
+            ::close(file_descriptor);
+            throw std::runtime_error("cannot stat " + path.string());
+        }
+
+        size = static_cast<std::size_t>(file_status.st_size);
+
+        if (size > 0) {
+            address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+        }
+
+        ::close(file_descriptor);
+
+        if (address == MAP_FAILED) {
+            address = nullptr;
+            throw std::runtime_error("cannot map " + path.string());
+        }
+    }
+
+    ~MappedFile() {
+        if (address != nullptr) {
+            ::munmap(address, size);
+        }
+    }
+
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    MappedFile(MappedFile &&other) = delete;
+    MappedFile &operator=(MappedFile &&other) = delete;
+
+    std::span<const std::byte> bytes() const {
+        return {static_cast<const std::byte *>(address), size};
+    }
+
+    /**
+     * @brief Forwards an access pattern hint (e.g. MADV_RANDOM, MADV_WILLNEED) for the whole mapping to the kernel
+     */
+    void advise(int advice) const {
+        if (address != nullptr) {
+            ::madvise(address, size, advice);
+        }
+    }
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "execution_backend.h"
+#include "graph.h"
+#include "perf_counters.h"
+
+/**
+ * @brief A set of up to 64 * words sources as a bit mask. With 4 words, the mask operations compile to 256-bit SIMD
+ */
+template<std::size_t words>
+struct SourceMask {
+    std::array<std::uint64_t, words> bits{};
+
+    SourceMask &operator|=(const SourceMask &other) {
+        for (std::size_t word_id = 0; word_id < words; word_id++) {
+            bits[word_id] |= other.bits[word_id];
+        }
+        return *this;
+    }
+
+    SourceMask and_not(const SourceMask &other) const {
+        SourceMask result{};
+        for (std::size_t word_id = 0; word_id < words; word_id++) {
+            result.bits[word_id] = bits[word_id] & ~other.bits[word_id];
+        }
+        return result;
+    }
+
+    bool empty() const {
+        std::uint64_t any = 0;
+        for (std::size_t word_id = 0; word_id < words; word_id++) {
+            any |= bits[word_id];
+        }
+        return any == 0;
+    }
+
+    void set(std::size_t source_id) {
+        bits[source_id / 64] |= std::uint64_t(1) << (source_id % 64);
+    }
+
+    template<typename Function>
+    void for_each_source(Function &&function) const {
+        for (std::size_t word_id = 0; word_id < words; word_id++) {
+            for (auto word = bits[word_id]; word != 0; word &= word - 1) {
+                function(word_id * 64 + std::countr_zero(word));
+            }
+        }
+    }
+};
+
+/**
+ * @brief Runs a bit-parallel BFS (MS-BFS, Then et al.) from the sources [first_source_id, first_source_id + number_sources).
+ *      Every vertex has a mask of the sources that have seen it and of the sources whose frontier contains it,
+ *      so every sweep over the adjacency advances the BFS of all sources of the batch by one level
+ * @param graph The graph, all edges must have the same weight
+ * @param first_source_id The first source of the batch
+ * @param number_sources The number of sources, at most 64 * words
+ * @param all_distances The distance matrix (same layout as all_pairs_shortest_paths), the rows of the sources are written
+ */
+template<std::size_t words>
+void multi_source_bfs(const CsrGraph &graph, vertex_type first_source_id, std::size_t number_sources,
+                      std::vector<distance_type> &all_distances) {
+    const auto number_vertices = graph.size();
+    const auto weight = graph.maximum_weight;
+
+    std::vector<SourceMask<words>> seen(number_vertices);
+    std::vector<SourceMask<words>> frontier(number_vertices);
+    std::vector<SourceMask<words>> next_frontier(number_vertices);
+
+    for (std::size_t source_id = 0; source_id < number_sources; source_id++) {
+        const auto source_vertex_id = first_source_id + source_id;
+        const auto offset = source_vertex_id * number_vertices;
+
+        std::fill_n(all_distances.begin() + offset, number_vertices, std::numeric_limits<distance_type>::max());
+        all_distances[offset + source_vertex_id] = 0;
+
+        seen[source_vertex_id].set(source_id);
+        frontier[source_vertex_id].set(source_id);
+    }
+
+    for (distance_type distance = weight; true; distance += weight) {
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            if (frontier[vertex_id].empty()) {
+                continue;
+            }
+
+            for (const auto neighbor_id: graph.neighbors(vertex_id)) {
+                next_frontier[neighbor_id] |= frontier[vertex_id];
+            }
+        }
+
+        auto any_visited = false;
+
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            const auto visited = next_frontier[vertex_id].and_not(seen[vertex_id]);
+
+            frontier[vertex_id] = visited;
+            next_frontier[vertex_id] = {};
+
+            if (visited.empty()) {
+                continue;
+            }
+
+            any_visited = true;
+            seen[vertex_id] |= visited;
+
+            visited.for_each_source([&](std::size_t source_id) {
+                all_distances[(first_source_id + source_id) * number_vertices + vertex_id] = distance;
+            });
+        }
+
+        if (!any_visited) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Calculates the all-pairs shortest-paths of a graph with uniform weights with MS-BFS,
+ *      64 * words sources per batch and the batches in parallel
+ * @return Same layout and values as all_pairs_shortest_paths
+ */
+template<std::size_t words = 4>
+std::vector<distance_type> all_pairs_shortest_paths_multi_source_bfs(const CsrGraph &graph) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+    if (!has_uniform_weights(graph)) {
+        throw std::invalid_argument("multi-source BFS needs a graph with uniform weights");
+    }
+
+    static constexpr std::size_t batch_size = 64 * words;
+
+    const auto number_vertices = graph.size();
+    const auto number_batches = (number_vertices + batch_size - 1) / batch_size;
+
+    std::vector<std::size_t> batch_indices(number_batches);
+    std::iota(batch_indices.begin(), batch_indices.end(), std::size_t(0));
+
+    std::vector<distance_type> all_distances(number_vertices * number_vertices);
+
+    parallel_for_each_source(batch_indices, [&all_distances, &graph, number_vertices](vertex_type batch_id) {
+        const auto first_source_id = static_cast<std::size_t>(batch_id) * batch_size;
+        const auto number_sources = std::min(batch_size, number_vertices - first_source_id);
+
+        multi_source_bfs<words>(graph, static_cast<vertex_type>(first_source_id), number_sources, all_distances);
+    });
+
+    return all_distances;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "graph.h"
+
+/*
+ * The distance matrix takes number_vertices^2 distances, so its width decides the memory traffic of the reductions.
+ * Most graphs do not need 32 bits: a shortest path visits every vertex at most once, so no finite distance is larger
+ * than maximum_path_length. The graph is copied into the narrowest BasicCsrGraph that holds
+ *      vertices:   all indices, 16 bits for up to 65536 vertices, otherwise vertex_type
+ *      distances:  maximum_path_length and the weights below the maximum, 8, 16 or 32 bits
+ * and Dijkstra, the matrix and the reductions are instantiated for those types. The maximum of every distance type is
+ * the distance of unreachable vertices, widen_distance maps it to the one of distance_type, so the results are the same
+ * as with the default types.
+ */
+
+struct NarrowestTypes {
+    std::size_t vertex_bytes;
+    std::size_t distance_bytes;
+};
+
+/**
+ * @return An upper bound of every finite shortest path of the graph: at most number_vertices - 1 edges of the
+ *      maximum weight, and at most every edge once, saturated at the maximum of std::uint64_t
+ */
+inline std::uint64_t maximum_path_length(const CsrGraph &graph) {
+    if (graph.size() <= 1) {
+        return 0;
+    }
+
+    const auto maximum_weight = static_cast<std::uint64_t>(graph.maximum_weight);
+    const auto number_path_edges = static_cast<std::uint64_t>(graph.size() - 1);
+    const auto longest_edges = maximum_weight != 0 && number_path_edges > std::numeric_limits<std::uint64_t>::max() / maximum_weight
+                               ? std::numeric_limits<std::uint64_t>::max()
+                               : number_path_edges * maximum_weight;
+
+    std::uint64_t all_edges = 0;
+    for (const auto weight: graph.weights) {
+        all_edges += weight;
+    }
+
+    return std::min(longest_edges, all_edges);
+}
+
+/**
+ * @brief Selects the narrowest vertex and distance types for the graph, see the top of this file
+ */
+inline NarrowestTypes select_narrowest_types(const CsrGraph &graph) {
+    const auto fits = [&graph]<typename Distance>(Distance) {
+        constexpr auto unreachable = std::numeric_limits<Distance>::max();
+        return maximum_path_length(graph) < unreachable && graph.maximum_weight < unreachable;
+    };
+
+    NarrowestTypes types{sizeof(vertex_type), sizeof(distance_type)};
+
+    if (graph.size() <= static_cast<std::size_t>(std::numeric_limits<std::uint16_t>::max()) + 1) {
+        types.vertex_bytes = sizeof(std::uint16_t);
+    }
+
+    if (fits(std::uint8_t())) {
+        types.distance_bytes = sizeof(std::uint8_t);
+    } else if (fits(std::uint16_t())) {
+        types.distance_bytes = sizeof(std::uint16_t);
+    }
+
+    return types;
+}
+
+/**
+ * @brief Copies the targets and the weights of the graph into narrower types, the offsets are shared.
+ *      Every index and weight must fit, see select_narrowest_types
+ */
+template<typename Vertex, typename Distance>
+BasicCsrGraph<Vertex, Distance> narrow_csr_graph(const CsrGraph &graph) {
+    if constexpr (std::is_same_v<Vertex, vertex_type> && std::is_same_v<Distance, distance_type>) {
+        return graph;
+    } else {
+        struct Buffers {
+            std::shared_ptr<const void> offsets_storage;
+            std::vector<Vertex> targets;
+            std::vector<Distance> weights;
+        };
+
+        auto buffers = std::make_shared<Buffers>(Buffers{graph.storage,
+                                                         std::vector<Vertex>(graph.targets.begin(), graph.targets.end()),
+                                                         std::vector<Distance>(graph.weights.begin(), graph.weights.end())});
+
+        BasicCsrGraph<Vertex, Distance> narrow_graph{graph.offsets, buffers->targets, buffers->weights,
+                                                     std::shared_ptr<const void>(buffers)};
+        update_weight_range(narrow_graph);
+
+        return narrow_graph;
+    }
+}
+
+template<typename Vertex, typename Function>
+decltype(auto) visit_narrowest_distance(const CsrGraph &graph, std::size_t distance_bytes, Function &&function) {
+    switch (distance_bytes) {
+        case sizeof(std::uint8_t):
+            return function(narrow_csr_graph<Vertex, std::uint8_t>(graph));
+        case sizeof(std::uint16_t):
+            return function(narrow_csr_graph<Vertex, std::uint16_t>(graph));
+        default:
+            return function(narrow_csr_graph<Vertex, distance_type>(graph));
+    }
+}
+
+/**
+ * @brief Calls function(graph) with the graph narrowed to the types of select_narrowest_types,
+ *      function must return the same type for all instantiations
+ */
+template<typename Function>
+decltype(auto) visit_narrowest_graph(const CsrGraph &graph, Function &&function) {
+    const auto types = select_narrowest_types(graph);
+
+    if (types.vertex_bytes == sizeof(std::uint16_t)) {
+        return visit_narrowest_distance<std::uint16_t>(graph, types.distance_bytes, function);
+    }
+    return visit_narrowest_distance<vertex_type>(graph, types.distance_bytes, function);
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "bfs.h"
+#include "dijkstra.h"
+#include "graph.h"
+#include "perf_counters.h"
+#include "priority_queues.h"
+
+/*
+ * NUMA-aware APSP. On a multi-socket machine, a std::vector matrix is zero-filled by the thread that creates it,
+ * so all of its pages land on the node of that thread, and the workers of the other nodes write their rows across
+ * the interconnect. Here the matrix is allocated without being touched, the workers are pinned to the cores of
+ * their node, and every row is first written by a worker of the node that owns it, so the kernel places its pages
+ * on that node. Every node with workers also gets its own copy of the (read-only) graph. A worker that finished the rows
+ * of its node takes the remaining rows of the other nodes, those are written remotely, but no worker idles while rows
+ * are left. Without NUMA information in sysfs, everything runs as one node.
+ */
+
+struct NumaNode {
+    int node_id;
+    std::vector<int> cpus;
+};
+
+/**
+ * @brief Parses a sysfs CPU list like "0-3,8-11"
+ */
+inline std::vector<int> parse_cpu_list(const std::string &cpu_list) {
+    std::vector<int> cpus{};
+    std::stringstream stream(cpu_list);
+
+    for (std::string range; std::getline(stream, range, ',');) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+
+        const auto dash = range.find('-');
+        const auto first_cpu = std::stoi(range.substr(0, dash));
+        const auto last_cpu = dash == std::string::npos ? first_cpu : std::stoi(range.substr(dash + 1));
+
+        for (auto cpu = first_cpu; cpu <= last_cpu; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+/**
+ * @brief Reads the NUMA nodes and their CPUs from /sys/devices/system/node, restricted to the CPUs this process
+ *      may run on. Falls back to a single node with all allowed CPUs
+ */
+inline std::vector<NumaNode> read_numa_topology() {
+    cpu_set_t allowed_cpus;
+    CPU_ZERO(&allowed_cpus);
+    const auto has_affinity = ::sched_getaffinity(0, sizeof(allowed_cpus), &allowed_cpus) == 0;
+
+    const auto is_allowed = [&](int cpu) {
+        return !has_affinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed_cpus));
+    };
+
+    std::vector<NumaNode> nodes{};
+    const std::filesystem::path node_directory = "/sys/devices/system/node";
+
+    std::error_code error{};
+    for (const auto &entry: std::filesystem::directory_iterator(node_directory, error)) {
+        const auto name = entry.path().filename().string();
+        if (!name.starts_with("node") || name.size() == 4 || !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            continue;
+        }
+
+        std::ifstream cpu_list_file(entry.path() / "cpulist");
+        std::string cpu_list{};
+        std::getline(cpu_list_file, cpu_list);
+
+        NumaNode node{std::stoi(name.substr(4)), {}};
+        for (const auto cpu: parse_cpu_list(cpu_list)) {
+            if (is_allowed(cpu)) {
+                node.cpus.push_back(cpu);
+            }
+        }
+
+        if (!node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+
+    if (nodes.empty()) {
+        NumaNode node{0, {}};
+        const auto number_cpus = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        for (int cpu = 0; cpu < std::max(number_cpus, CPU_SETSIZE) && static_cast<int>(node.cpus.size()) < number_cpus; cpu++) {
+            if (is_allowed(cpu)) {
+                node.cpus.push_back(cpu);
+            }
+        }
+        if (node.cpus.empty()) {
+            node.cpus.push_back(0);
+        }
+        nodes.push_back(std::move(node));
+    }
+
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode &lhs, const NumaNode &rhs) {
+        return lhs.node_id < rhs.node_id;
+    });
+
+    return nodes;
+}
+
+/**
+ * @brief Restricts the calling thread to the given CPUs, silently keeps the old affinity if that is not allowed
+ */
+inline void pin_current_thread(std::span<const int> cpus) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto cpu: cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(cpu_set), &cpu_set);
+}
+
+/**
+ * @brief Runs the function on a thread pinned to the node and returns its result,
+ *      so the memory that the function allocates and fills is placed on that node
+ */
+template<typename Function>
+auto run_on_node(const NumaNode &node, Function &&function) {
+    decltype(function()) result{};
+
+    std::thread runner([&node, &function, &result] {
+        pin_current_thread(node.cpus);
+        result = function();
+    });
+    runner.join();
+
+    return result;
+}
+
+/**
+ * @brief Copies the graph on the node, see run_on_node
+ */
+inline CsrGraph replicate_graph_on_node(const CsrGraph &graph, const NumaNode &node) {
+    return run_on_node(node, [&graph] {
+        return make_csr_graph(std::vector<std::uint64_t>(graph.offsets.begin(), graph.offsets.end()),
+                              std::vector<vertex_type>(graph.targets.begin(), graph.targets.end()),
+                              std::vector<distance_type>(graph.weights.begin(), graph.weights.end()));
+    });
+}
+
+/**
+ * @brief A distance matrix (same layout as all_pairs_shortest_paths) whose pages are not touched when it is allocated
+ */
+struct NumaDistanceMatrix {
+    std::unique_ptr<distance_type[]> data{};
+    std::size_t number_vertices = 0;
+
+    std::span<const distance_type> distances() const {
+        return {data.get(), number_vertices * number_vertices};
+    }
+
+    std::span<distance_type> row(vertex_type source_vertex_id) {
+        return {data.get() + static_cast<std::size_t>(source_vertex_id) * number_vertices, number_vertices};
+    }
+};
+
+/**
+ * @brief Calculates the all-pairs shortest-paths with workers pinned to the NUMA nodes. The rows are split into one
+ *      contiguous block per node, proportional to its number of workers, and the workers of a node take the rows of
+ *      its block one by one, so every row is first touched on the node that owns it. Then they take the rows left in
+ *      the blocks of the other nodes, starting with the next node
+ * @tparam Queue The priority queue policy of Dijkstra, see priority_queues.h
+ * @param graph The graph, a graph with uniform weights uses the direction-optimizing BFS
+ * @param number_threads The number of workers, spread round-robin over the nodes and pinned to one core each
+ * @return The distance matrix
+ */
+template<typename Queue = BinaryHeapQueue>
+NumaDistanceMatrix all_pairs_shortest_paths_numa(const CsrGraph &graph, unsigned int number_threads) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+    const auto nodes = read_numa_topology();
+    const auto number_nodes = nodes.size();
+    const auto number_vertices = graph.size();
+    const auto uniform_weights = has_uniform_weights(graph);
+
+    // worker i runs on node i % number_nodes, i.e., both sockets are used before any of them is full
+    number_threads = std::max(number_threads, 1u);
+    std::vector<std::size_t> workers_per_node(number_nodes, 0);
+    for (unsigned int worker_id = 0; worker_id < number_threads; worker_id++) {
+        workers_per_node[worker_id % number_nodes]++;
+    }
+
+    // nodes without workers neither read the graph nor own rows
+    std::vector<CsrGraph> replicas(number_nodes);
+    std::vector<CsrGraph> reverse_replicas(number_nodes);
+    for (std::size_t node_index = 0; node_index < number_nodes; node_index++) {
+        if (workers_per_node[node_index] == 0) {
+            continue;
+        }
+
+        const auto &node = nodes[node_index];
+        auto &replica = replicas[node_index];
+        replica = number_nodes == 1 ? graph : replicate_graph_on_node(graph, node);
+        if (uniform_weights) {
+            reverse_replicas[node_index] = run_on_node(node, [&replica] { return transpose_graph(replica); });
+        }
+    }
+
+    std::vector<std::size_t> first_rows(number_nodes + 1, 0);
+    std::size_t preceding_workers = 0;
+    for (std::size_t node_index = 0; node_index < number_nodes; node_index++) {
+        preceding_workers += workers_per_node[node_index];
+        first_rows[node_index + 1] = number_vertices * preceding_workers / number_threads;
+    }
+
+    std::vector<std::atomic<std::size_t>> next_rows(number_nodes);
+    for (std::size_t node_index = 0; node_index < number_nodes; node_index++) {
+        next_rows[node_index] = first_rows[node_index];
+    }
+
+    NumaDistanceMatrix matrix{std::make_unique_for_overwrite<distance_type[]>(number_vertices * number_vertices), number_vertices};
+
+    const auto worker = [&](unsigned int worker_id) {
+        const auto node_index = worker_id % number_nodes;
+        const auto &node_graph = replicas[node_index];
+        const auto &node_cpus = nodes[node_index].cpus;
+        pin_current_thread(std::span<const int>(&node_cpus[(worker_id / number_nodes) % node_cpus.size()], 1));
+
+        std::optional<DirectionOptimizingBfs> bfs{};
+        if (uniform_weights) {
+            bfs.emplace(node_graph, reverse_replicas[node_index]);
+        }
+
+        // the block of the own node first, then the rows left in the blocks of the other nodes
+        for (std::size_t node_offset = 0; node_offset < number_nodes; node_offset++) {
+            const auto block_index = (node_index + node_offset) % number_nodes;
+            const auto last_row = first_rows[block_index + 1];
+            auto &next_row = next_rows[block_index];
+
+            for (auto row = next_row++; row < last_row; row = next_row++) {
+                const auto source_vertex_id = static_cast<vertex_type>(row);
+                if (bfs) {
+                    bfs->shortest_paths(source_vertex_id, matrix.row(source_vertex_id));
+                } else {
+                    dijkstra_shortest_paths<Queue>(node_graph, source_vertex_id, matrix.row(source_vertex_id));
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads{};
+    for (unsigned int worker_id = 0; worker_id < number_threads; worker_id++) {
+        threads.emplace_back(worker, worker_id);
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    return matrix;
+}
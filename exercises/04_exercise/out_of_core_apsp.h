@@ -0,0 +1,388 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "dijkstra.h"
+#include "execution_backend.h"
+#include "graph.h"
+#include "perf_counters.h"
+#include "priority_queues.h"
+#include "streaming_apsp.h"
+
+/*
+ * Out-of-core APSP for graphs whose distance matrix does not fit into memory. The rows are calculated in batches of
+ * sources, every batch is compressed into a tile and written to a file, and the reductions read the tiles back in a
+ * streaming pass. The tile file:
+ *      DistanceTileFileHeader
+ *      tiles : (DistanceTileHeader, the rows first_row, ..., first_row + number_rows - 1 compressed back to back)*
+ * A row is compressed as one LEB128 varint per distance, storing distance + 1 and 0 for unreachable vertices,
+ * so the typical small distances take one byte instead of four.
+ * While the workers calculate the next batch, a writer thread writes the previous one (double buffering), so the
+ * memory of the tiles is bounded by two batches.
+ */
+constexpr std::array<char, 8> distance_tile_magic = {'A', 'P', 'S', 'P', 'T', 'I', 'L', 'E'};
+constexpr std::uint32_t distance_tile_version = 1;
+
+// the largest encoding of a distance, 7 bits per byte
+constexpr std::size_t maximum_encoded_distance_size = (sizeof(distance_type) * 8 + 6) / 7;
+
+struct DistanceTileFileHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t distance_size;
+    std::uint64_t number_vertices;
+    std::uint64_t rows_per_tile;
+};
+
+struct DistanceTileHeader {
+    std::uint64_t first_row;
+    std::uint64_t number_rows;
+    std::uint64_t compressed_size;
+};
+
+struct OutOfCoreStatistics {
+    std::size_t rows_per_tile = 0;
+    std::size_t number_tiles = 0;
+    std::uint64_t raw_bytes = 0;
+    std::uint64_t compressed_bytes = 0;
+};
+
+/**
+ * @brief Appends the compressed row to the bytes
+ */
+inline void encode_distance_row(std::span<const distance_type> distances, std::vector<std::uint8_t> &bytes) {
+    for (const auto distance: distances) {
+        auto value = distance == std::numeric_limits<distance_type>::max() ? distance_type(0) : distance + 1;
+
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+}
+
+/**
+ * @brief Decompresses one row
+ * @param distances Receives the row, must have one element per vertex
+ * @return The first byte after the row
+ */
+inline const std::uint8_t *decode_distance_row(const std::uint8_t *begin, const std::uint8_t *end,
+                                               std::span<distance_type> distances) {
+    for (auto &distance: distances) {
+        distance_type value = 0;
+        unsigned int shift = 0;
+
+        while (true) {
+            if (begin == end || shift >= sizeof(distance_type) * 8) {
+                throw std::runtime_error("the distance tile is truncated or corrupted");
+            }
+            const auto byte = *begin++;
+            value |= static_cast<distance_type>(byte & 0x7f) << shift;
+            shift += 7;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        distance = value == 0 ? std::numeric_limits<distance_type>::max() : value - 1;
+    }
+
+    return begin;
+}
+
+/**
+ * @brief A batch of compressed rows, every row has its own buffer so the workers can compress in parallel
+ */
+struct DistanceTile {
+    std::uint64_t first_row = 0;
+    std::vector<std::vector<std::uint8_t>> rows{};
+
+    std::uint64_t compressed_size() const {
+        return std::accumulate(rows.begin(), rows.end(), std::uint64_t(0), [](std::uint64_t sum, const auto &row) {
+            return sum + row.size();
+        });
+    }
+};
+
+/**
+ * @brief Writes tiles on its own thread. submit hands over a tile and returns as soon as the previous one is written,
+ *      so the caller can fill the other buffer meanwhile, but must not touch the submitted tile before the next submit
+ *      or finish returned
+ */
+class AsyncTileWriter {
+    std::ofstream file;
+    std::thread thread{};
+    std::mutex mutex{};
+    std::condition_variable condition{};
+    const DistanceTile *pending_tile = nullptr;
+    bool finishing = false;
+    std::exception_ptr error{};
+
+    void write_tiles() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return pending_tile != nullptr || finishing; });
+            if (pending_tile == nullptr) {
+                return;
+            }
+            const auto *tile = pending_tile;
+            lock.unlock();
+
+            try {
+                const DistanceTileHeader header{tile->first_row, tile->rows.size(), tile->compressed_size()};
+                file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+                for (const auto &row: tile->rows) {
+                    file.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size()));
+                }
+                if (!file) {
+                    throw std::runtime_error("cannot write the distance tiles");
+                }
+            } catch (...) {
+                lock.lock();
+                error = std::current_exception();
+                lock.unlock();
+            }
+
+            lock.lock();
+            pending_tile = nullptr;
+            condition.notify_all();
+        }
+    }
+
+    void wait_until_written() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return pending_tile == nullptr; });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+public:
+    AsyncTileWriter(const std::filesystem::path &path, const DistanceTileFileHeader &header) :
+            file(path, std::ios::binary | std::ios::trunc) {
+        if (!file) {
+            throw std::runtime_error("cannot create " + path.string());
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        thread = std::thread(&AsyncTileWriter::write_tiles, this);
+    }
+
+    ~AsyncTileWriter() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            finishing = true;
+        }
+        condition.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    AsyncTileWriter(const AsyncTileWriter &) = delete;
+    AsyncTileWriter &operator=(const AsyncTileWriter &) = delete;
+
+    void submit(const DistanceTile &tile) {
+        wait_until_written();
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            pending_tile = &tile;
+        }
+        condition.notify_all();
+    }
+
+    /**
+     * @brief Waits for the last tile and flushes the file
+     */
+    void finish() {
+        wait_until_written();
+        if (!file.flush()) {
+            throw std::runtime_error("cannot write the distance tiles");
+        }
+    }
+};
+
+/**
+ * @brief Removes a file when it goes out of scope, e.g., when an exception leaves a temporary file behind
+ */
+class TemporaryFileRemover {
+    std::filesystem::path path;
+
+public:
+    explicit TemporaryFileRemover(std::filesystem::path path) :
+            path(std::move(path)) {
+    }
+
+    ~TemporaryFileRemover() {
+        std::error_code error{};
+        std::filesystem::remove(path, error);
+    }
+
+    TemporaryFileRemover(const TemporaryFileRemover &) = delete;
+    TemporaryFileRemover &operator=(const TemporaryFileRemover &) = delete;
+};
+
+/**
+ * @return How many rows a batch may have, so that two batches of worst-case compressed rows fit into the budget
+ */
+inline std::size_t out_of_core_rows_per_tile(std::size_t number_vertices, std::size_t memory_budget_bytes) {
+    const auto row_bytes = std::max<std::size_t>(number_vertices * maximum_encoded_distance_size, 1);
+    return std::clamp<std::size_t>(memory_budget_bytes / (2 * row_bytes), 1, std::max<std::size_t>(number_vertices, 1));
+}
+
+/**
+ * @brief Calculates the all-pairs shortest-paths batch by batch and writes them as compressed tiles, the matrix is never
+ *      in memory. The file is written next to the destination and renamed over it, like write_distance_matrix
+ * @tparam Queue The priority queue policy of Dijkstra, see priority_queues.h
+ * @param connectivity The adjacency list of the graph, either as maps or in CSR layout
+ * @param path The tile file that is created or replaced
+ * @param memory_budget_bytes The memory for the two batches of compressed rows, at least one row per batch is used
+ *      whatever the budget. The graph and one distance row per worker come on top
+ * @return The size of the batches and how well they compressed
+ */
+template<typename Queue = BinaryHeapQueue, typename Graph>
+OutOfCoreStatistics write_all_pairs_shortest_paths_tiles(const Graph &connectivity, const std::filesystem::path &path,
+                                                         std::size_t memory_budget_bytes) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+
+    const auto number_vertices = connectivity.size();
+    const auto rows_per_tile = out_of_core_rows_per_tile(number_vertices, memory_budget_bytes);
+
+    auto temporary_path = path;
+    temporary_path += ".tmp";
+    // only left to remove if writing failed, otherwise it was renamed
+    const TemporaryFileRemover temporary_remover(temporary_path);
+
+    OutOfCoreStatistics statistics{rows_per_tile, 0, 0, 0};
+    std::array<DistanceTile, 2> tiles{};
+    std::vector<std::size_t> sources{};
+
+    {
+        AsyncTileWriter writer(temporary_path, {distance_tile_magic, distance_tile_version, sizeof(distance_type),
+                                                number_vertices, rows_per_tile});
+
+        for (std::size_t first_row = 0; first_row < number_vertices; first_row += rows_per_tile) {
+            const auto number_rows = std::min(rows_per_tile, number_vertices - first_row);
+
+            // the writer may still write the other tile, this one was written before the last submit returned
+            auto &tile = tiles[statistics.number_tiles % 2];
+            tile.first_row = first_row;
+            tile.rows.resize(number_rows);
+
+            sources.resize(number_rows);
+            std::iota(sources.begin(), sources.end(), first_row);
+
+            parallel_for_each_source(sources, [&connectivity, &tile, first_row, number_vertices](vertex_type source_vertex_id) {
+                // the uncompressed row is only needed until it is encoded, so every thread reuses one
+                thread_local std::vector<distance_type> distances{};
+                distances.resize(number_vertices);
+                dijkstra_shortest_paths<Queue>(connectivity, source_vertex_id, std::span(distances));
+
+                auto &row = tile.rows[source_vertex_id - first_row];
+                row.clear();
+                encode_distance_row(distances, row);
+            });
+
+            statistics.number_tiles++;
+            statistics.raw_bytes += number_rows * number_vertices * sizeof(distance_type);
+            statistics.compressed_bytes += tile.compressed_size();
+
+            writer.submit(tile);
+        }
+
+        writer.finish();
+    }
+
+    std::filesystem::rename(temporary_path, path);
+
+    return statistics;
+}
+
+/**
+ * @return A tile file path in the temporary directory that no other process and no other call uses,
+ *      from the process id and a counter
+ */
+inline std::filesystem::path temporary_tile_path() {
+    static std::atomic<std::uint64_t> next_tile_file_id = 0;
+
+    const auto tile_file_id = next_tile_file_id.fetch_add(1, std::memory_order::relaxed);
+    return std::filesystem::temp_directory_path() /
+           ("apsp_tiles_" + std::to_string(::getpid()) + "_" + std::to_string(tile_file_id) + ".bin");
+}
+
+/**
+ * @brief Streams the rows of a tile file into the reducers, see streaming_apsp.h. Only one tile and one row are in memory
+ * @tparam Reducers The reducers, see the top of streaming_apsp.h
+ * @param path The tile file, see write_all_pairs_shortest_paths_tiles
+ * @return The reducers after they consumed all rows
+ */
+template<typename... Reducers>
+std::tuple<Reducers...> reduce_distance_tiles(const std::filesystem::path &path) {
+    const PerfStageScope stage_scope(PerfStage::reduction);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("cannot open " + path.string());
+    }
+
+    DistanceTileFileHeader header{};
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != distance_tile_magic) {
+        throw std::runtime_error(path.string() + " is not a distance tile file");
+    }
+    if (header.version != distance_tile_version || header.distance_size != sizeof(distance_type)) {
+        throw std::runtime_error(path.string() + " has an unsupported distance tile version");
+    }
+
+    const auto number_vertices = static_cast<std::size_t>(header.number_vertices);
+    std::tuple<Reducers...> reducers{Reducers(number_vertices)...};
+
+    std::vector<std::uint8_t> compressed_rows{};
+    std::vector<distance_type> distances(number_vertices);
+    std::uint64_t next_row = 0;
+
+    for (DistanceTileHeader tile_header{}; next_row < number_vertices; next_row += tile_header.number_rows) {
+        if (!file.read(reinterpret_cast<char *>(&tile_header), sizeof(tile_header)) || tile_header.first_row != next_row ||
+            tile_header.number_rows == 0 || tile_header.number_rows > number_vertices - next_row ||
+            tile_header.compressed_size > tile_header.number_rows * number_vertices * maximum_encoded_distance_size) {
+            throw std::runtime_error(path.string() + " is truncated or corrupted");
+        }
+
+        compressed_rows.resize(tile_header.compressed_size);
+        if (!file.read(reinterpret_cast<char *>(compressed_rows.data()), static_cast<std::streamsize>(compressed_rows.size()))) {
+            throw std::runtime_error(path.string() + " is truncated or corrupted");
+        }
+
+        const auto *position = compressed_rows.data();
+        const auto *end = compressed_rows.data() + compressed_rows.size();
+        for (std::uint64_t row_id = 0; row_id < tile_header.number_rows; row_id++) {
+            position = decode_distance_row(position, end, distances);
+
+            std::apply([&](auto &... reducer) {
+                (reducer.consume(static_cast<vertex_type>(tile_header.first_row + row_id), distances), ...);
+            }, reducers);
+        }
+    }
+
+    return reducers;
+}
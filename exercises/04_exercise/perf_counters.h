@@ -0,0 +1,290 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#ifdef APSP_PERF_COUNTERS
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Optional hardware counters around the stages of the APSP variants, built with -DAPSP_PERF_COUNTERS=ON
+ * (see CMakeLists.txt), otherwise every scope below is empty and costs nothing.
+ *
+ * The counters are opened once per process with perf_event_open and are inherited by every thread created afterwards,
+ * so the loader threads, the work-stealing pool, the TBB workers and the pinned NUMA workers all count into them and
+ * the kernel sums their per-thread values when they are read. A stage therefore covers the work of all threads while
+ * it runs, including the time they spend spinning or waiting, and measured stages must not overlap.
+ * Threads that already exist when the counters are opened are not counted, so the program should call
+ * open_perf_counters() before it starts any.
+ * If the kernel refuses a counter (no PMU in a VM, perf_event_paranoid, ...), the stages are still timed.
+ *
+ * Stages are only recorded inside a PerfVariantScope, which names the variant they are accounted to:
+ *      PerfVariantScope variant_scope("parallel_lock/csr");
+ *      do_work_parallel_lock(connectivity);   // its shortest_paths and reduction stages are recorded
+ * The variant is per thread, so only the stages that the thread of the PerfVariantScope enters are recorded, the stages
+ * that the workers enter inside of them (which the counters already cover) are not.
+ * The streaming variant reduces the rows while it calculates them, so it only has a shortest_paths stage.
+ */
+
+enum class PerfStage {
+    graph_load,
+    reordering,
+    shortest_paths,
+    reduction,
+};
+
+inline const char *perf_stage_name(PerfStage stage) {
+    switch (stage) {
+        case PerfStage::graph_load:
+            return "graph_load";
+        case PerfStage::reordering:
+            return "reordering";
+        case PerfStage::shortest_paths:
+            return "shortest_paths";
+        case PerfStage::reduction:
+            return "reduction";
+    }
+    return "unknown";
+}
+
+constexpr std::size_t number_perf_events = 4;
+constexpr std::array<const char *, number_perf_events> perf_event_names = {"cycles", "instructions", "LLC misses",
+                                                                           "branch misses"};
+
+struct PerfCounterValues {
+    std::array<std::uint64_t, number_perf_events> events{};
+    std::uint64_t nanoseconds = 0;
+    std::uint64_t number_calls = 0;
+};
+
+/**
+ * @brief The process-wide counters, one file descriptor per event, -1 if the event is not available
+ */
+class PerfCounters {
+    std::array<int, number_perf_events> descriptors{-1, -1, -1, -1};
+
+#ifdef APSP_PERF_COUNTERS
+    static int open_event(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attributes{};
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.inherit = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+#endif
+
+public:
+    PerfCounters() {
+#ifdef APSP_PERF_COUNTERS
+        descriptors = {open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES),
+                       open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+                       open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+                       open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES)};
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef APSP_PERF_COUNTERS
+        for (const auto descriptor: descriptors) {
+            if (descriptor >= 0) {
+                ::close(descriptor);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available(std::size_t event_id) const {
+        return descriptors[event_id] >= 0;
+    }
+
+    /**
+     * @return The current value of every event, scaled up if the kernel had to multiplex the counters, 0 if unavailable
+     */
+    std::array<std::uint64_t, number_perf_events> read() const {
+        std::array<std::uint64_t, number_perf_events> values{};
+
+#ifdef APSP_PERF_COUNTERS
+        for (std::size_t event_id = 0; event_id < number_perf_events; event_id++) {
+            // value, time enabled, time running
+            std::array<std::uint64_t, 3> buffer{};
+            if (descriptors[event_id] < 0 || ::read(descriptors[event_id], buffer.data(), sizeof(buffer)) != sizeof(buffer)) {
+                continue;
+            }
+
+            const auto &[value, time_enabled, time_running] = buffer;
+            values[event_id] = time_running == 0 || time_running == time_enabled
+                               ? value
+                               : static_cast<std::uint64_t>(static_cast<double>(value) * time_enabled / time_running);
+        }
+#endif
+
+        return values;
+    }
+};
+
+inline PerfCounters &open_perf_counters() {
+    static PerfCounters counters{};
+    return counters;
+}
+
+/**
+ * @brief The recorded stages, (variant, stage) -> summed values
+ */
+struct PerfCounterReport {
+    std::mutex mutex{};
+    std::map<std::pair<std::string, PerfStage>, PerfCounterValues> stages{};
+};
+
+inline PerfCounterReport &perf_counter_report() {
+    static PerfCounterReport report{};
+    return report;
+}
+
+/**
+ * @brief The variant that stages of the calling thread are accounted to, empty outside of a PerfVariantScope
+ */
+inline std::string &current_perf_variant() {
+    thread_local std::string variant{};
+    return variant;
+}
+
+class PerfVariantScope {
+#ifdef APSP_PERF_COUNTERS
+    std::string previous_variant;
+#endif
+
+public:
+    explicit PerfVariantScope([[maybe_unused]] std::string variant) {
+#ifdef APSP_PERF_COUNTERS
+        previous_variant = std::exchange(current_perf_variant(), std::move(variant));
+#endif
+    }
+
+    ~PerfVariantScope() {
+#ifdef APSP_PERF_COUNTERS
+        current_perf_variant() = std::move(previous_variant);
+#endif
+    }
+
+    PerfVariantScope(const PerfVariantScope &) = delete;
+    PerfVariantScope &operator=(const PerfVariantScope &) = delete;
+};
+
+/**
+ * @brief Records the counters and the time between its construction and destruction as the stage of the current variant.
+ *      Nested scopes on the same thread are ignored, the outermost one records the stage
+ */
+class PerfStageScope {
+#ifdef APSP_PERF_COUNTERS
+    static int &depth() {
+        thread_local int scope_depth = 0;
+        return scope_depth;
+    }
+
+    PerfStage stage;
+    bool recording;
+    std::array<std::uint64_t, number_perf_events> events_before{};
+    std::chrono::steady_clock::time_point time_before{};
+#endif
+
+public:
+    explicit PerfStageScope([[maybe_unused]] PerfStage stage) {
+#ifdef APSP_PERF_COUNTERS
+        this->stage = stage;
+        recording = depth()++ == 0 && !current_perf_variant().empty();
+        if (recording) {
+            events_before = open_perf_counters().read();
+            time_before = std::chrono::steady_clock::now();
+        }
+#endif
+    }
+
+    ~PerfStageScope() {
+#ifdef APSP_PERF_COUNTERS
+        depth()--;
+        if (!recording) {
+            return;
+        }
+
+        const auto time_after = std::chrono::steady_clock::now();
+        const auto events_after = open_perf_counters().read();
+
+        auto &report = perf_counter_report();
+        const std::lock_guard<std::mutex> lock(report.mutex);
+        auto &values = report.stages[{current_perf_variant(), stage}];
+
+        for (std::size_t event_id = 0; event_id < number_perf_events; event_id++) {
+            values.events[event_id] += events_after[event_id] - events_before[event_id];
+        }
+        values.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(time_after - time_before).count();
+        values.number_calls++;
+#endif
+    }
+
+    PerfStageScope(const PerfStageScope &) = delete;
+    PerfStageScope &operator=(const PerfStageScope &) = delete;
+};
+
+/**
+ * @brief Prints one line per recorded variant and stage, with the events that are not available as "-"
+ */
+inline void print_perf_counter_report(std::ostream &stream) {
+    auto &report = perf_counter_report();
+    const std::lock_guard<std::mutex> lock(report.mutex);
+
+    if (report.stages.empty()) {
+        return;
+    }
+
+    const auto &counters = open_perf_counters();
+
+    stream << std::left << std::setw(28) << "variant" << std::setw(16) << "stage" << std::right << std::setw(8) << "calls"
+           << std::setw(12) << "time [ms]";
+    for (const auto *event_name: perf_event_names) {
+        stream << std::setw(16) << event_name;
+    }
+    stream << std::setw(8) << "IPC" << '\n';
+
+    for (const auto &[key, values]: report.stages) {
+        stream << std::left << std::setw(28) << key.first << std::setw(16) << perf_stage_name(key.second) << std::right
+               << std::setw(8) << values.number_calls << std::fixed << std::setprecision(2)
+               << std::setw(12) << static_cast<double>(values.nanoseconds) / 1e6;
+
+        for (std::size_t event_id = 0; event_id < number_perf_events; event_id++) {
+            if (counters.available(event_id)) {
+                stream << std::setw(16) << values.events[event_id];
+            } else {
+                stream << std::setw(16) << "-";
+            }
+        }
+
+        const auto cycles = values.events[0];
+        if (counters.available(0) && counters.available(1) && cycles > 0) {
+            stream << std::setw(8) << static_cast<double>(values.events[1]) / static_cast<double>(cycles);
+        } else {
+            stream << std::setw(8) << "-";
+        }
+        stream << '\n' << std::defaultfloat;
+    }
+}
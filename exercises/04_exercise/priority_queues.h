@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+
+/*
+ * The priority queues in this file are the policies for dijkstra_shortest_paths. Each of them has the interface
+ *      Queue(number_vertices, maximum_edge_weight)  maximum_edge_weight is only set if Queue::uses_maximum_edge_weight
+ *      bool empty() const
+ *      void push(vertex_id, distance)     inserts the vertex, or lowers its distance if it is already queued
+ *      VertexDistancePair pop()           removes and returns an entry with the smallest distance
+ *      void reset()                       empties the queue for the next search, keeping its storage,
+ *                                         and only touches what the last search left behind
+ * The queues with lazy deletion may return stale entries, i.e., a vertex with a larger distance than it already has,
+ * Dijkstra skips those.
+ */
+
+/**
+ * @brief Binary heap with lazy deletion, i.e., a decrease-key pushes a new entry and the old one becomes stale
+ */
+class BinaryHeapQueue {
+public:
+    static constexpr bool uses_maximum_edge_weight = false;
+
+private:
+    // a std::priority_queue cannot be cleared without giving up its storage
+    std::vector<VertexDistancePair> heap{};
+
+public:
+    BinaryHeapQueue([[maybe_unused]] std::size_t number_vertices, [[maybe_unused]] distance_type maximum_edge_weight) {}
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    void push(vertex_type vertex_id, distance_type distance) {
+        heap.emplace_back(vertex_id, distance);
+        std::push_heap(heap.begin(), heap.end(), std::greater<VertexDistancePair>());
+    }
+
+    VertexDistancePair pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<VertexDistancePair>());
+        const auto top = heap.back();
+        heap.pop_back();
+        return top;
+    }
+
+    void reset() {
+        heap.clear();
+    }
+};
+
+/**
+ * @brief Indexed d-ary heap with decrease-key, so every vertex is at most once in the heap and there are no stale entries.
+ *      A larger arity makes the heap shallower, which makes decrease-key cheaper and the children of a node share cache lines
+ */
+template<std::size_t arity = 4>
+class DaryHeapQueue {
+    static_assert(arity >= 2);
+
+public:
+    static constexpr bool uses_maximum_edge_weight = false;
+
+private:
+    static constexpr auto not_in_heap = std::numeric_limits<std::uint32_t>::max();
+
+    std::vector<VertexDistancePair> heap{};
+    std::vector<std::uint32_t> positions{};
+
+    void place(std::size_t position, const VertexDistancePair &entry) {
+        heap[position] = entry;
+        positions[entry.vertex_index] = static_cast<std::uint32_t>(position);
+    }
+
+    void sift_up(std::size_t position) {
+        const auto entry = heap[position];
+
+        while (position > 0) {
+            const auto parent = (position - 1) / arity;
+            if (heap[parent].distance <= entry.distance) {
+                break;
+            }
+
+            place(position, heap[parent]);
+            position = parent;
+        }
+
+        place(position, entry);
+    }
+
+    void sift_down(std::size_t position) {
+        const auto entry = heap[position];
+        const auto size = heap.size();
+
+        while (true) {
+            const auto first_child = position * arity + 1;
+            if (first_child >= size) {
+                break;
+            }
+
+            const auto last_child = std::min(first_child + arity, size);
+
+            auto smallest_child = first_child;
+            for (auto child = first_child + 1; child < last_child; child++) {
+                if (heap[child].distance < heap[smallest_child].distance) {
+                    smallest_child = child;
+                }
+            }
+
+            if (heap[smallest_child].distance >= entry.distance) {
+                break;
+            }
+
+            place(position, heap[smallest_child]);
+            position = smallest_child;
+        }
+
+        place(position, entry);
+    }
+
+public:
+    DaryHeapQueue(std::size_t number_vertices, [[maybe_unused]] distance_type maximum_edge_weight) :
+            positions(number_vertices, not_in_heap) {
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    void push(vertex_type vertex_id, distance_type distance) {
+        const auto position = positions[vertex_id];
+
+        if (position == not_in_heap) {
+            heap.emplace_back(vertex_id, distance);
+            sift_up(heap.size() - 1);
+            return;
+        }
+
+        if (distance < heap[position].distance) {
+            heap[position].distance = distance;
+            sift_up(position);
+        }
+    }
+
+    VertexDistancePair pop() {
+        const auto top = heap.front();
+        positions[top.vertex_index] = not_in_heap;
+
+        const auto last = heap.back();
+        heap.pop_back();
+
+        if (!heap.empty()) {
+            heap.front() = last;
+            sift_down(0);
+        }
+
+        return top;
+    }
+
+    void reset() {
+        for (const auto &entry: heap) {
+            positions[entry.vertex_index] = not_in_heap;
+        }
+        heap.clear();
+    }
+};
+
+/**
+ * @brief Radix heap for monotone integer keys, i.e., no pushed distance is smaller than the last popped one,
+ *      which holds for Dijkstra with non-negative weights. An entry is kept in the bucket of the highest bit in which
+ *      it differs from the last popped distance, so every entry moves at most once per bit and pop is amortized O(1).
+ *      Uses lazy deletion
+ */
+class RadixHeapQueue {
+public:
+    static constexpr bool uses_maximum_edge_weight = false;
+
+private:
+    static constexpr std::size_t number_buckets = std::numeric_limits<distance_type>::digits + 1;
+
+    std::array<std::vector<VertexDistancePair>, number_buckets> buckets{};
+    std::size_t size = 0;
+    distance_type last_distance = 0;
+
+    std::size_t bucket_index(distance_type distance) const {
+        return static_cast<std::size_t>(std::bit_width(distance ^ last_distance));
+    }
+
+public:
+    RadixHeapQueue([[maybe_unused]] std::size_t number_vertices, [[maybe_unused]] distance_type maximum_edge_weight) {}
+
+    bool empty() const {
+        return size == 0;
+    }
+
+    void push(vertex_type vertex_id, distance_type distance) {
+        buckets[bucket_index(distance)].emplace_back(vertex_id, distance);
+        size++;
+    }
+
+    VertexDistancePair pop() {
+        if (buckets[0].empty()) {
+            auto index = std::size_t(1);
+            while (buckets[index].empty()) {
+                index++;
+            }
+
+            auto &bucket = buckets[index];
+            last_distance = std::min_element(bucket.begin(), bucket.end(), [](const auto &lhs, const auto &rhs) {
+                return lhs.distance < rhs.distance;
+            })->distance;
+
+            for (const auto &entry: bucket) {
+                buckets[bucket_index(entry.distance)].push_back(entry);
+            }
+            bucket.clear();
+        }
+
+        const auto top = buckets[0].back();
+        buckets[0].pop_back();
+        size--;
+
+        return top;
+    }
+
+    void reset() {
+        for (auto &bucket: buckets) {
+            bucket.clear();
+        }
+        size = 0;
+        last_distance = 0;
+    }
+};
+
+/**
+ * @brief Dial's bucket queue for small integer weights. All queued distances are in
+ *      [current_distance, current_distance + maximum_edge_weight], so a ring of maximum_edge_weight + 1 buckets
+ *      holds one bucket per distance and push and pop are O(1) (pop scans at most maximum_edge_weight empty buckets).
+ *      Like the radix heap, it needs monotone keys, and it needs one bucket per possible weight,
+ *      so it only suits small weights, at most maximum_supported_edge_weight. Uses lazy deletion
+ */
+class DialBucketQueue {
+public:
+    static constexpr bool uses_maximum_edge_weight = true;
+    // the ring takes (maximum_edge_weight + 1) * sizeof(std::vector) bytes, 24 MiB at this limit,
+    // larger weights need a queue that does not depend on them, e.g., RadixHeapQueue
+    static constexpr distance_type maximum_supported_edge_weight = distance_type(1) << 20;
+
+private:
+    std::vector<std::vector<vertex_type>> buckets{};
+    std::size_t size = 0;
+    distance_type current_distance = 0;
+
+public:
+    DialBucketQueue([[maybe_unused]] std::size_t number_vertices, distance_type maximum_edge_weight) {
+        if (maximum_edge_weight > maximum_supported_edge_weight) {
+            throw std::invalid_argument("Dial's bucket queue supports edge weights up to " +
+                                        std::to_string(maximum_supported_edge_weight) + ", the graph has " +
+                                        std::to_string(maximum_edge_weight));
+        }
+        buckets.resize(static_cast<std::size_t>(maximum_edge_weight) + 1);
+    }
+
+    bool empty() const {
+        return size == 0;
+    }
+
+    void push(vertex_type vertex_id, distance_type distance) {
+        buckets[distance % buckets.size()].push_back(vertex_id);
+        size++;
+    }
+
+    VertexDistancePair pop() {
+        auto *bucket = &buckets[current_distance % buckets.size()];
+        while (bucket->empty()) {
+            current_distance++;
+            bucket = &buckets[current_distance % buckets.size()];
+        }
+
+        const auto vertex_id = bucket->back();
+        bucket->pop_back();
+        size--;
+
+        return {vertex_id, current_distance};
+    }
+
+    void reset() {
+        // after a search, all buckets are empty already
+        if (size > 0) {
+            for (auto &bucket: buckets) {
+                bucket.clear();
+            }
+        }
+        size = 0;
+        current_distance = 0;
+    }
+};
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "distance_matrix_file.h"
+#include "graph.h"
+
+void print_distance(distance_type distance) {
+    if (distance == std::numeric_limits<distance_type>::max()) {
+        std::cout << "unreachable";
+    } else {
+        std::cout << distance;
+    }
+}
+
+/**
+ * Answers queries on a distance matrix file written by 04_exercise_apsp, without loading the whole file:
+ *      04_exercise_query_distances <matrix> point <source> <target>
+ *      04_exercise_query_distances <matrix> row <source>
+ *      04_exercise_query_distances <matrix> furthest <target>
+ *      04_exercise_query_distances <matrix> batch [<pairs>]     one "source target" pair per line, stdin if omitted
+ */
+int main(int argc, char **argv) {
+    const std::string command = argc > 2 ? argv[2] : "";
+
+    if (!(argc == 5 && command == "point") && !(argc == 4 && (command == "row" || command == "furthest")) &&
+        !((argc == 3 || argc == 4) && command == "batch")) {
+        std::cerr << "Usage: " << argv[0] << " <matrix> point <source> <target>\n"
+                  << "       " << argv[0] << " <matrix> row <source>\n"
+                  << "       " << argv[0] << " <matrix> furthest <target>\n"
+                  << "       " << argv[0] << " <matrix> batch [<file with one \"source target\" pair per line>]\n";
+        return 1;
+    }
+
+    try {
+        const DistanceMatrixFile matrix(argv[1]);
+
+        if (command == "point") {
+            print_distance(matrix.distance(std::stoi(argv[3]), std::stoi(argv[4])));
+            std::cout << '\n';
+        } else if (command == "row") {
+            const auto row = matrix.row(std::stoi(argv[3]));
+            for (std::size_t target_vertex_id = 0; target_vertex_id < row.size(); target_vertex_id++) {
+                std::cout << target_vertex_id << ' ';
+                print_distance(row[target_vertex_id]);
+                std::cout << '\n';
+            }
+        } else if (command == "furthest") {
+            const auto furthest = matrix.furthest_reaching_vertex(std::stoi(argv[3]));
+            std::cout << furthest.vertex_index << ' ';
+            print_distance(furthest.distance);
+            std::cout << '\n';
+        } else {
+            std::ifstream file{};
+            if (argc == 4) {
+                file.open(argv[3]);
+                if (!file) {
+                    throw std::runtime_error("cannot open " + std::string(argv[3]));
+                }
+            }
+            auto &input = argc == 4 ? static_cast<std::istream &>(file) : std::cin;
+
+            std::vector<std::pair<vertex_type, vertex_type>> queries{};
+            std::string line{};
+            for (std::size_t line_number = 1; std::getline(input, line); line_number++) {
+                if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                    continue;
+                }
+
+                std::istringstream fields(line);
+                vertex_type source_vertex_id, target_vertex_id;
+                if (!(fields >> source_vertex_id >> target_vertex_id) || !(fields >> std::ws).eof()) {
+                    throw std::runtime_error("line " + std::to_string(line_number) + " is not a \"source target\" pair: " + line);
+                }
+                queries.emplace_back(source_vertex_id, target_vertex_id);
+            }
+            if (!input.eof()) {
+                throw std::runtime_error("cannot read the queries");
+            }
+
+            std::vector<distance_type> results(queries.size());
+
+            const auto before_batch = std::chrono::high_resolution_clock::now();
+            matrix.distances_batch(queries, results);
+            const auto after_batch = std::chrono::high_resolution_clock::now();
+
+            for (std::size_t query_id = 0; query_id < queries.size(); query_id++) {
+                std::cout << queries[query_id].first << ' ' << queries[query_id].second << ' ';
+                print_distance(results[query_id]);
+                std::cout << '\n';
+            }
+            std::cerr << "Answered " << queries.size() << " queries in " << (after_batch - before_batch).count() << " ns.\n";
+        }
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
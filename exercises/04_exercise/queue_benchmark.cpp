@@ -0,0 +1,130 @@
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "delta_stepping.h"
+#include "dijkstra.h"
+#include "graph.h"
+#include "graph_io.h"
+#include "priority_queues.h"
+
+/**
+ * Compares the priority queue policies of dijkstra_shortest_paths, and the parallel delta-stepping, on the specified graph
+ * (default ./graph.txt) and on generated random graphs with small and with large weights:
+ *      04_exercise_queue_benchmark [graph]
+ */
+
+/**
+ * @brief Generates a random directed graph, every vertex gets average_degree edges to uniformly chosen targets,
+ *      with weights uniformly chosen in [1, maximum_weight]
+ */
+CsrGraph make_random_graph(vertex_type number_vertices, vertex_type average_degree, distance_type maximum_weight,
+                           unsigned int seed) {
+    std::mt19937_64 generator(seed);
+    std::uniform_int_distribution<vertex_type> vertex_distribution(0, number_vertices - 1);
+    std::uniform_int_distribution<distance_type> weight_distribution(1, maximum_weight);
+
+    std::vector<Edge> edges{};
+    edges.reserve(static_cast<std::size_t>(number_vertices) * average_degree);
+
+    for (vertex_type source_vertex_id = 0; source_vertex_id < number_vertices; source_vertex_id++) {
+        for (vertex_type edge_id = 0; edge_id < average_degree; edge_id++) {
+            edges.emplace_back(source_vertex_id, vertex_distribution(generator), weight_distribution(generator));
+        }
+    }
+
+    return make_csr_graph(number_vertices, std::move(edges));
+}
+
+/**
+ * @brief Runs the single-source search from the first number_sources vertices
+ * @param shortest_paths Returns the distances from a source, like dijkstra_shortest_paths
+ * @return The concatenated distance rows and the time it took in ns
+ */
+template<typename ShortestPaths>
+std::pair<std::vector<distance_type>, double> run_sources(const CsrGraph &graph, vertex_type number_sources,
+                                                          ShortestPaths &&shortest_paths) {
+    std::vector<distance_type> all_distances{};
+    all_distances.reserve(static_cast<std::size_t>(number_sources) * graph.size());
+
+    const auto before_calculation = std::chrono::high_resolution_clock::now();
+    for (vertex_type source_vertex_id = 0; source_vertex_id < number_sources; source_vertex_id++) {
+        const auto &distances = shortest_paths(source_vertex_id);
+        all_distances.insert(all_distances.end(), distances.begin(), distances.end());
+    }
+    const auto after_calculation = std::chrono::high_resolution_clock::now();
+
+    return {std::move(all_distances), static_cast<double>((after_calculation - before_calculation).count())};
+}
+
+/**
+ * @brief Runs Dijkstra with the specified queue from the first number_sources vertices, see run_sources
+ */
+template<typename Queue>
+std::pair<std::vector<distance_type>, double> run_sources(const CsrGraph &graph, vertex_type number_sources) {
+    return run_sources(graph, number_sources, [&graph](vertex_type source_vertex_id) {
+        return dijkstra_shortest_paths<Queue>(graph, source_vertex_id);
+    });
+}
+
+template<typename ShortestPaths>
+void benchmark_search(const std::string &name, const CsrGraph &graph, vertex_type number_sources,
+                      const std::vector<distance_type> &reference_distances, double reference_time,
+                      ShortestPaths &&shortest_paths) {
+    const auto &[distances, time] = run_sources(graph, number_sources, shortest_paths);
+
+    std::cout << "  " << std::left << std::setw(20) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(0) << time / number_sources << " ns/source"
+              << std::setw(8) << std::setprecision(2) << reference_time / time << "x"
+              << (distances == reference_distances ? "" : "  MISMATCH") << '\n';
+}
+
+template<typename Queue>
+void benchmark_queue(const std::string &name, const CsrGraph &graph, vertex_type number_sources,
+                     const std::vector<distance_type> &reference_distances, double reference_time) {
+    benchmark_search(name, graph, number_sources, reference_distances, reference_time, [&graph](vertex_type source_vertex_id) {
+        return dijkstra_shortest_paths<Queue>(graph, source_vertex_id);
+    });
+}
+
+void benchmark_all_queues(const std::string &name, const CsrGraph &graph, std::size_t maximum_sources) {
+    const auto number_sources = static_cast<vertex_type>(std::min(graph.size(), maximum_sources));
+
+    std::cout << name << ": " << graph.size() << " vertices, " << graph.number_edges() << " edges, weights in ["
+              << graph.minimum_weight << ", " << graph.maximum_weight << "], " << number_sources << " sources\n";
+
+    // warm up the caches and the allocator before the reference run
+    run_sources<BinaryHeapQueue>(graph, std::min<vertex_type>(number_sources, 10));
+    const auto &[reference_distances, reference_time] = run_sources<BinaryHeapQueue>(graph, number_sources);
+
+    benchmark_queue<BinaryHeapQueue>("binary heap", graph, number_sources, reference_distances, reference_time);
+    benchmark_queue<DaryHeapQueue<2>>("indexed 2-heap", graph, number_sources, reference_distances, reference_time);
+    benchmark_queue<DaryHeapQueue<4>>("indexed 4-heap", graph, number_sources, reference_distances, reference_time);
+    benchmark_queue<DaryHeapQueue<8>>("indexed 8-heap", graph, number_sources, reference_distances, reference_time);
+    benchmark_queue<RadixHeapQueue>("radix heap", graph, number_sources, reference_distances, reference_time);
+    if (graph.maximum_weight <= DialBucketQueue::maximum_supported_edge_weight) {
+        benchmark_queue<DialBucketQueue>("dial buckets", graph, number_sources, reference_distances, reference_time);
+    } else {
+        std::cout << "  dial buckets        skipped, the weights are too large\n";
+    }
+
+    const auto number_threads = parallel_number_threads();
+    benchmark_search("delta-stepping x" + std::to_string(number_threads), graph, number_sources, reference_distances,
+                     reference_time, [&graph, number_threads](vertex_type source_vertex_id) {
+                         return delta_stepping_shortest_paths(graph, source_vertex_id, 0, number_threads);
+                     });
+}
+
+int main(int argc, char **argv) {
+    const std::filesystem::path graph_path = argc > 1 ? argv[1] : "./graph.txt";
+
+    benchmark_all_queues(graph_path.string(), load_graph(graph_path), 1000);
+    benchmark_all_queues("random, small weights", make_random_graph(20000, 8, 16, 42), 200);
+    benchmark_all_queues("random, large weights", make_random_graph(20000, 8, 100000, 42), 200);
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dijkstra.h"
+#include "execution_backend.h"
+#include "graph.h"
+#include "perf_counters.h"
+#include "priority_queues.h"
+
+/*
+ * The shortest-path trees of all sources, kept next to the distance matrix so paths can be reconstructed without
+ * a search for every query. Row s holds the predecessor of every vertex on a shortest path from s. Two modes:
+ *      all trees       graphs with fewer than 65535 vertices, every row as 16-bit predecessors,
+ *                      i.e., half the memory of the distance matrix
+ *      cached trees    larger graphs, where 32-bit predecessors would double the memory of the matrix. Only the
+ *                      trees of the last cache_capacity sources are kept, a miss recalculates the tree of the source
+ *                      with one Dijkstra and evicts the least recently used one
+ */
+
+/**
+ * @brief The number of trees kept by the cached mode of all_pairs_shortest_paths_with_trees
+ */
+constexpr std::size_t default_cached_shortest_path_trees = 64;
+
+class ShortestPathTrees {
+public:
+    // calculate_tree(source, predecessors) writes the tree of the source like dijkstra_shortest_path_tree
+    using TreeCalculator = std::function<void(vertex_type, std::span<std::uint32_t>)>;
+
+private:
+    struct TreeCache {
+        TreeCalculator calculate_tree;
+        std::size_t capacity;
+        std::mutex mutex{};
+        // the most recently used tree first
+        std::list<std::pair<vertex_type, std::vector<std::uint32_t>>> trees{};
+        std::size_t number_misses = 0;
+    };
+
+    std::size_t vertex_count = 0;
+    std::vector<std::uint16_t> narrow_predecessors{};
+    std::unique_ptr<TreeCache> cache{};
+
+    void check_vertex(vertex_type vertex_id) const {
+        if (vertex_id < 0 || static_cast<std::size_t>(vertex_id) >= vertex_count) {
+            throw std::out_of_range("vertex " + std::to_string(vertex_id) + " is not in the shortest-path trees");
+        }
+    }
+
+    template<typename Predecessor>
+    static vertex_type to_vertex(Predecessor predecessor) {
+        return predecessor == std::numeric_limits<Predecessor>::max() ? vertex_type(-1) : static_cast<vertex_type>(predecessor);
+    }
+
+    /**
+     * @brief Calls function(tree) with the predecessors of the source as a span of the stored integer type,
+     *      in the cached mode under the lock of the cache, after recalculating the tree on a miss
+     */
+    template<typename Function>
+    decltype(auto) visit_tree(vertex_type source_vertex_id, Function &&function) const {
+        if (!cache) {
+            const auto offset = static_cast<std::size_t>(source_vertex_id) * vertex_count;
+            return function(std::span<const std::uint16_t>(narrow_predecessors.data() + offset, vertex_count));
+        }
+
+        const std::lock_guard<std::mutex> lock(cache->mutex);
+        auto &trees = cache->trees;
+
+        auto tree = std::find_if(trees.begin(), trees.end(), [source_vertex_id](const auto &entry) {
+            return entry.first == source_vertex_id;
+        });
+
+        if (tree == trees.end()) {
+            cache->number_misses++;
+            // the evicted tree keeps its storage for the new one
+            if (trees.size() >= cache->capacity) {
+                trees.splice(trees.begin(), trees, std::prev(trees.end()));
+            } else {
+                trees.emplace_front(source_vertex_id, std::vector<std::uint32_t>(vertex_count));
+            }
+            trees.front().first = source_vertex_id;
+            cache->calculate_tree(source_vertex_id, trees.front().second);
+        } else {
+            trees.splice(trees.begin(), trees, tree);
+        }
+
+        return function(std::span<const std::uint32_t>(trees.front().second));
+    }
+
+public:
+    ShortestPathTrees() = default;
+
+    /**
+     * @brief All trees, filled through visit_row
+     */
+    explicit ShortestPathTrees(std::size_t number_vertices) :
+            vertex_count(number_vertices), narrow_predecessors(number_vertices * number_vertices) {
+        if (!fits_narrow_predecessors(number_vertices)) {
+            throw std::invalid_argument("all shortest-path trees are only stored for fewer than 65535 vertices");
+        }
+    }
+
+    /**
+     * @brief Cached trees, at most cache_capacity of them (at least one) are kept and recalculated by calculate_tree
+     */
+    ShortestPathTrees(std::size_t number_vertices, TreeCalculator calculate_tree, std::size_t cache_capacity) :
+            vertex_count(number_vertices),
+            cache(std::make_unique<TreeCache>(std::move(calculate_tree), std::max<std::size_t>(cache_capacity, 1))) {
+    }
+
+    static bool fits_narrow_predecessors(std::size_t number_vertices) {
+        return number_vertices < std::numeric_limits<std::uint16_t>::max();
+    }
+
+    std::size_t number_vertices() const {
+        return vertex_count;
+    }
+
+    bool stores_all_trees() const {
+        return !cache;
+    }
+
+    /**
+     * @return The number of trees recalculated in the cached mode, 0 if all trees are stored
+     */
+    std::size_t number_recalculated_trees() const {
+        if (!cache) {
+            return 0;
+        }
+        const std::lock_guard<std::mutex> lock(cache->mutex);
+        return cache->number_misses;
+    }
+
+    std::size_t size_bytes() const {
+        if (!cache) {
+            return narrow_predecessors.size() * sizeof(std::uint16_t);
+        }
+        const std::lock_guard<std::mutex> lock(cache->mutex);
+        return cache->trees.size() * vertex_count * sizeof(std::uint32_t);
+    }
+
+    /**
+     * @brief Calls function(row) with the predecessors of the source to fill them, only if all trees are stored
+     */
+    template<typename Function>
+    void visit_row(vertex_type source_vertex_id, Function &&function) {
+        if (cache) {
+            throw std::logic_error("the cached shortest-path trees are calculated on demand");
+        }
+        const auto offset = static_cast<std::size_t>(source_vertex_id) * vertex_count;
+        function(std::span<std::uint16_t>(narrow_predecessors.data() + offset, vertex_count));
+    }
+
+    /**
+     * @return The vertex before target_vertex_id on a shortest path source_vertex_id--->target_vertex_id,
+     *      -1 if target_vertex_id is the source or unreachable
+     */
+    vertex_type predecessor(vertex_type source_vertex_id, vertex_type target_vertex_id) const {
+        check_vertex(source_vertex_id);
+        check_vertex(target_vertex_id);
+        return visit_tree(source_vertex_id, [target_vertex_id](auto predecessors) {
+            return to_vertex(predecessors[target_vertex_id]);
+        });
+    }
+
+    /**
+     * @brief Reconstructs a shortest path by walking the tree of the source back from the target, without allocating
+     *      (except for a recalculated tree in the cached mode)
+     * @param path_buffer Receives the path at its end, a buffer with number_vertices elements fits every path
+     * @return The vertices source_vertex_id, ..., target_vertex_id of the path as the tail of path_buffer,
+     *      empty if target_vertex_id is unreachable
+     */
+    std::span<vertex_type> path(vertex_type source_vertex_id, vertex_type target_vertex_id,
+                                std::span<vertex_type> path_buffer) const {
+        check_vertex(source_vertex_id);
+        check_vertex(target_vertex_id);
+
+        return visit_tree(source_vertex_id, [&](auto predecessors) -> std::span<vertex_type> {
+            if (target_vertex_id != source_vertex_id && to_vertex(predecessors[target_vertex_id]) == -1) {
+                return {};
+            }
+
+            auto first = path_buffer.size();
+            for (auto vertex_id = target_vertex_id; vertex_id != -1; vertex_id = to_vertex(predecessors[vertex_id])) {
+                if (first == 0) {
+                    throw std::length_error("the path does not fit into the buffer");
+                }
+                path_buffer[--first] = vertex_id;
+            }
+
+            return path_buffer.subspan(first);
+        });
+    }
+};
+
+struct DistancesAndShortestPathTrees {
+    std::vector<distance_type> all_pairs_shortest_paths;
+    ShortestPathTrees shortest_path_trees;
+};
+
+/**
+ * @brief Calculates the all-pairs shortest-paths like all_pairs_shortest_paths_parallel and also the shortest-path
+ *		trees of all sources, see ShortestPathTrees
+ * @tparam Queue The priority queue policy of Dijkstra, see priority_queues.h
+ * @param connectivity The adjacency list of the graph, either as maps or in CSR layout. Graphs with 65535 or more vertices
+ *		get cached trees, which keep a copy of the graph to recalculate them (a view of the arrays for CSR graphs)
+ * @param cached_trees The capacity of the cached trees
+ * @return The distance matrix (same layout as all_pairs_shortest_paths) and the trees
+ */
+template<typename Queue = BinaryHeapQueue, typename Graph>
+DistancesAndShortestPathTrees all_pairs_shortest_paths_with_trees(const Graph &connectivity,
+                                                                  std::size_t cached_trees = default_cached_shortest_path_trees) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+
+    const auto number_vertices = connectivity.size();
+    const auto sources = order_sources_by_cost(connectivity);
+
+    if (!ShortestPathTrees::fits_narrow_predecessors(number_vertices)) {
+        auto calculate_tree = [graph = std::make_shared<const Graph>(connectivity),
+                               distances = std::vector<distance_type>(number_vertices)]
+                (vertex_type source_vertex_id, std::span<std::uint32_t> predecessors) mutable {
+            dijkstra_shortest_path_tree<Queue>(*graph, source_vertex_id, std::span(distances), predecessors);
+        };
+
+        DistancesAndShortestPathTrees result{std::vector<distance_type>(number_vertices * number_vertices),
+                                             ShortestPathTrees(number_vertices, std::move(calculate_tree), cached_trees)};
+
+        parallel_for_each_source(sources, [&result, &connectivity, number_vertices](vertex_type source_vertex_id) {
+            dijkstra_shortest_paths<Queue>(connectivity, source_vertex_id,
+                                           std::span(result.all_pairs_shortest_paths.data() + source_vertex_id * number_vertices,
+                                                     number_vertices));
+        });
+
+        return result;
+    }
+
+    DistancesAndShortestPathTrees result{std::vector<distance_type>(number_vertices * number_vertices),
+                                         ShortestPathTrees(number_vertices)};
+
+    parallel_for_each_source(sources, [&result, &connectivity, number_vertices](vertex_type source_vertex_id) {
+        const std::span<distance_type> distances(result.all_pairs_shortest_paths.data() + source_vertex_id * number_vertices,
+                                                 number_vertices);
+
+        result.shortest_path_trees.visit_row(source_vertex_id, [&](auto predecessors) {
+            dijkstra_shortest_path_tree<Queue>(connectivity, source_vertex_id, distances, predecessors);
+        });
+    });
+
+    return result;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "bfs.h"
+#include "dijkstra.h"
+#include "execution_backend.h"
+#include "graph.h"
+#include "perf_counters.h"
+
+/*
+ * The reducers in this file consume the shortest-path rows one by one, so the all-pairs matrix never has to exist.
+ * Each of them has the interface
+ *      Reducer(number_vertices)
+ *      void consume(source_vertex_id, distances)   distances[i] is the shortest path source_vertex_id--->i
+ *      void merge(const Reducer &other)             adds the rows another (thread-local) reducer consumed
+ * and the result is independent of the order in which the rows are consumed and merged.
+ */
+
+/**
+ * @brief Same result as calculate_largest_smallest_path, i.e., the argmax of every column, the smallest source wins ties
+ */
+struct FurthestReachingVertexReducer {
+    std::vector<VertexDistancePair> furthest_reaching_vertex;
+
+    explicit FurthestReachingVertexReducer(std::size_t number_vertices) :
+            furthest_reaching_vertex(number_vertices) {
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            furthest_reaching_vertex[vertex_id] = {vertex_id, 0};
+        }
+    }
+
+    void consume(vertex_type source_vertex_id, std::span<const distance_type> distances) {
+        for (std::size_t target_vertex_id = 0; target_vertex_id < distances.size(); target_vertex_id++) {
+            auto &furthest = furthest_reaching_vertex[target_vertex_id];
+            const auto current_distance = distances[target_vertex_id];
+
+            if (current_distance > furthest.distance ||
+                (current_distance == furthest.distance && current_distance > 0 && source_vertex_id < furthest.vertex_index)) {
+                furthest = {source_vertex_id, current_distance};
+            }
+        }
+    }
+
+    void merge(const FurthestReachingVertexReducer &other) {
+        for (std::size_t target_vertex_id = 0; target_vertex_id < furthest_reaching_vertex.size(); target_vertex_id++) {
+            auto &furthest = furthest_reaching_vertex[target_vertex_id];
+            const auto &other_furthest = other.furthest_reaching_vertex[target_vertex_id];
+
+            if (other_furthest.distance > furthest.distance ||
+                (other_furthest.distance == furthest.distance && other_furthest.vertex_index < furthest.vertex_index)) {
+                furthest = other_furthest;
+            }
+        }
+    }
+};
+
+/**
+ * @brief The eccentricity of every vertex, i.e., the length of the longest shortest path from it,
+ *      std::numeric_limits<distance_type>::max() if it cannot reach all vertices
+ */
+struct EccentricityReducer {
+    std::vector<distance_type> eccentricity;
+
+    explicit EccentricityReducer(std::size_t number_vertices) :
+            eccentricity(number_vertices, 0) {
+    }
+
+    void consume(vertex_type source_vertex_id, std::span<const distance_type> distances) {
+        eccentricity[source_vertex_id] = *std::max_element(distances.begin(), distances.end());
+    }
+
+    void merge(const EccentricityReducer &other) {
+        for (std::size_t vertex_id = 0; vertex_id < eccentricity.size(); vertex_id++) {
+            eccentricity[vertex_id] = std::max(eccentricity[vertex_id], other.eccentricity[vertex_id]);
+        }
+    }
+};
+
+/**
+ * @brief For every vertex, the sum of the distances to and the number of the vertices it can reach (including itself),
+ *      the closeness centrality is (number_reachable - 1) / distance_sum
+ */
+struct ClosenessReducer {
+    std::vector<std::uint64_t> distance_sum;
+    std::vector<std::uint32_t> number_reachable;
+
+    explicit ClosenessReducer(std::size_t number_vertices) :
+            distance_sum(number_vertices, 0), number_reachable(number_vertices, 0) {
+    }
+
+    void consume(vertex_type source_vertex_id, std::span<const distance_type> distances) {
+        std::uint64_t sum = 0;
+        std::uint32_t reachable = 0;
+
+        for (const auto distance: distances) {
+            if (distance != std::numeric_limits<distance_type>::max()) {
+                sum += distance;
+                reachable++;
+            }
+        }
+
+        distance_sum[source_vertex_id] = sum;
+        number_reachable[source_vertex_id] = reachable;
+    }
+
+    void merge(const ClosenessReducer &other) {
+        for (std::size_t vertex_id = 0; vertex_id < distance_sum.size(); vertex_id++) {
+            distance_sum[vertex_id] += other.distance_sum[vertex_id];
+            number_reachable[vertex_id] += other.number_reachable[vertex_id];
+        }
+    }
+
+    double closeness(vertex_type vertex_id) const {
+        return distance_sum[vertex_id] == 0 ? 0.0
+                                            : static_cast<double>(number_reachable[vertex_id] - 1) / distance_sum[vertex_id];
+    }
+};
+
+/**
+ * @brief How many ordered pairs of vertices have which shortest-path distance,
+ *      unreachable pairs are counted under std::numeric_limits<distance_type>::max()
+ */
+struct DistanceHistogramReducer {
+    std::map<distance_type, std::uint64_t> histogram{};
+
+    explicit DistanceHistogramReducer([[maybe_unused]] std::size_t number_vertices) {}
+
+    void consume([[maybe_unused]] vertex_type source_vertex_id, std::span<const distance_type> distances) {
+        // distances are mostly small, counting them in a flat array first avoids a map lookup per pair
+        static constexpr distance_type flat_limit = 1024;
+        std::array<std::uint64_t, flat_limit> flat_counts{};
+
+        for (const auto distance: distances) {
+            if (distance < flat_limit) {
+                flat_counts[distance]++;
+            } else {
+                histogram[distance]++;
+            }
+        }
+
+        for (distance_type distance = 0; distance < flat_limit; distance++) {
+            if (flat_counts[distance] != 0) {
+                histogram[distance] += flat_counts[distance];
+            }
+        }
+    }
+
+    void merge(const DistanceHistogramReducer &other) {
+        for (const auto&[distance, count]: other.histogram) {
+            histogram[distance] += count;
+        }
+    }
+};
+
+/**
+ * @brief Calculates the shortest paths from every vertex and streams each row into the reducers instead of
+ *      storing the all-pairs matrix. The sources are dealt to chunks by decreasing estimated cost, the chunks run on the
+ *      parallel backend (see execution_backend.h) and consume their rows into their own reducers, which are merged at
+ *      the end, so the memory is O(number_vertices * number_chunks) instead of O(number_vertices^2)
+ * @tparam Reducers The reducers, see the top of this file
+ * @param connectivity The adjacency list of the graph, either as maps or in CSR layout
+ * @param number_chunks The number of chunks, 0 picks 4 per thread of the per-source loops (APSP_NUM_THREADS),
+ *      so the threads that finish early can take over the remaining chunks
+ * @return The merged reducers
+ */
+template<typename... Reducers, typename Graph>
+std::tuple<Reducers...> stream_all_pairs_shortest_paths(const Graph &connectivity, std::size_t number_chunks = 0) {
+    const PerfStageScope stage_scope(PerfStage::shortest_paths);
+    const auto number_vertices = connectivity.size();
+    if (number_chunks == 0) {
+        number_chunks = 4 * static_cast<std::size_t>(parallel_number_threads());
+    }
+    number_chunks = std::clamp<std::size_t>(number_chunks, 1, std::max<std::size_t>(number_vertices, 1));
+
+    std::vector<std::tuple<Reducers...>> partial_reducers{};
+    partial_reducers.reserve(number_chunks);
+    for (std::size_t chunk_id = 0; chunk_id < number_chunks; chunk_id++) {
+        partial_reducers.emplace_back(Reducers(number_vertices)...);
+    }
+
+    // shared read-only by all chunks, only the BFS scratch is per chunk
+    const auto uniform_weights = [&connectivity] {
+        if constexpr (std::is_same_v<Graph, CsrGraph>) {
+            return has_uniform_weights(connectivity);
+        }
+        return false;
+    }();
+    const auto reverse_graph = [&connectivity, uniform_weights] {
+        if constexpr (std::is_same_v<Graph, CsrGraph>) {
+            if (uniform_weights) {
+                return transpose_graph(connectivity);
+            }
+        }
+        return CsrGraph{};
+    }();
+
+    // chunk c gets the sources c, c + number_chunks, ... of the cost order, so all chunks cost about the same
+    const auto sources = order_sources_by_cost(connectivity);
+    std::vector<std::size_t> chunks(number_chunks);
+    std::iota(chunks.begin(), chunks.end(), std::size_t(0));
+
+    parallel_for_each_source(chunks, [&](vertex_type chunk_id) {
+        auto &reducers = partial_reducers[chunk_id];
+        std::vector<distance_type> distances(number_vertices);
+
+        const auto for_each_source = [&](auto &&calculate_row) {
+            for (auto position = static_cast<std::size_t>(chunk_id); position < number_vertices; position += number_chunks) {
+                const auto source_vertex_id = static_cast<vertex_type>(sources[position]);
+                calculate_row(source_vertex_id);
+
+                std::apply([&](auto &... reducer) {
+                    (reducer.consume(source_vertex_id, std::span<const distance_type>(distances)), ...);
+                }, reducers);
+            }
+        };
+
+        if constexpr (std::is_same_v<Graph, CsrGraph>) {
+            if (uniform_weights) {
+                DirectionOptimizingBfs bfs(connectivity, reverse_graph);
+                for_each_source([&](vertex_type source_vertex_id) {
+                    bfs.shortest_paths(source_vertex_id, distances);
+                });
+                return;
+            }
+        }
+
+        for_each_source([&](vertex_type source_vertex_id) {
+            dijkstra_shortest_paths(connectivity, source_vertex_id, std::span(distances));
+        });
+    });
+
+    auto &result = partial_reducers.front();
+    for (std::size_t chunk_id = 1; chunk_id < number_chunks; chunk_id++) {
+        std::apply([&](auto &... reducer) {
+            std::apply([&](const auto &... other_reducer) {
+                (reducer.merge(other_reducer), ...);
+            }, partial_reducers[chunk_id]);
+        }, result);
+    }
+
+    return std::move(result);
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "execution_backend.h"
+#include "graph.h"
+#include "perf_counters.h"
+
+/*
+ * Relabels the vertices before the per-source searches, so that vertices which are close in the graph are also close
+ * in the distance rows and in the CSR arrays, and the inner loop of Dijkstra touches fewer cache lines:
+ *      original                the order of the input
+ *      reverse_cuthill_mckee   BFS from a peripheral vertex that visits the neighbors by ascending degree, reversed,
+ *                              which keeps the bandwidth max |i - j| over the edges small
+ *      degree_descending       the hubs first, so the entries that are touched most share the first cache lines
+ *      bfs                     BFS order from vertex 0, neighbors get consecutive indices
+ * The orderings look at the edges in both directions. The results of the relabeled graph are mapped back to the original
+ * vertex indices, see restore_distances and restore_furthest_reaching_vertex.
+ */
+
+enum class VertexOrdering {
+    original,
+    reverse_cuthill_mckee,
+    degree_descending,
+    bfs,
+};
+
+inline const char *vertex_ordering_name(VertexOrdering ordering) {
+    switch (ordering) {
+        case VertexOrdering::original:
+            return "original";
+        case VertexOrdering::reverse_cuthill_mckee:
+            return "rcm";
+        case VertexOrdering::degree_descending:
+            return "degree";
+        case VertexOrdering::bfs:
+            return "bfs";
+    }
+    return "unknown";
+}
+
+inline VertexOrdering parse_vertex_ordering(const std::string &name) {
+    for (const auto ordering: {VertexOrdering::original, VertexOrdering::reverse_cuthill_mckee,
+                               VertexOrdering::degree_descending, VertexOrdering::bfs}) {
+        if (name == vertex_ordering_name(ordering)) {
+            return ordering;
+        }
+    }
+    throw std::invalid_argument("unknown vertex ordering " + name);
+}
+
+/**
+ * @brief A relabeled graph, vertex i of graph is vertex new_to_old[i] of the original one and vice versa
+ */
+struct ReorderedGraph {
+    CsrGraph graph;
+    std::vector<vertex_type> new_to_old;
+    std::vector<vertex_type> old_to_new;
+};
+
+/**
+ * @brief Visits the vertices reachable from start in BFS order, appending them to order,
+ *      the neighbors of a vertex are visited in the order of its list in undirected_graph
+ */
+inline void append_bfs_order(const CsrGraph &undirected_graph, vertex_type start_vertex_id,
+                                    std::vector<std::uint8_t> &visited, std::vector<vertex_type> &order) {
+    auto head = order.size();
+    visited[start_vertex_id] = 1;
+    order.push_back(start_vertex_id);
+
+    while (head < order.size()) {
+        const auto vertex_id = order[head++];
+        for (const auto neighbor_id: undirected_graph.neighbors(vertex_id)) {
+            if (visited[neighbor_id] == 0) {
+                visited[neighbor_id] = 1;
+                order.push_back(neighbor_id);
+            }
+        }
+    }
+}
+
+/**
+ * @brief The union of the graph and its transpose without weights, i.e., the neighbors of a vertex in both directions
+ * @param sort_by_degree Sorts every neighbor list by ascending degree instead of ascending index
+ */
+inline CsrGraph make_undirected_graph(const CsrGraph &graph, bool sort_by_degree) {
+    const auto number_vertices = static_cast<vertex_type>(graph.size());
+    const auto reverse_graph = transpose_graph(graph);
+
+    std::vector<std::uint64_t> offsets{0};
+    std::vector<vertex_type> targets{};
+    offsets.reserve(graph.size() + 1);
+    targets.reserve(2 * graph.number_edges());
+
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        const auto outgoing = graph.neighbors(vertex_id);
+        const auto incoming = reverse_graph.neighbors(vertex_id);
+
+        // both lists are sorted, so their union is a merge
+        const auto first = targets.size();
+        std::set_union(outgoing.begin(), outgoing.end(), incoming.begin(), incoming.end(), std::back_inserter(targets));
+        targets.erase(std::remove(targets.begin() + static_cast<std::ptrdiff_t>(first), targets.end(), vertex_id), targets.end());
+        offsets.push_back(targets.size());
+    }
+
+    if (sort_by_degree) {
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            std::stable_sort(targets.begin() + static_cast<std::ptrdiff_t>(offsets[vertex_id]),
+                             targets.begin() + static_cast<std::ptrdiff_t>(offsets[vertex_id + 1]),
+                             [&offsets](vertex_type lhs, vertex_type rhs) {
+                                 return offsets[lhs + 1] - offsets[lhs] < offsets[rhs + 1] - offsets[rhs];
+                             });
+        }
+    }
+
+    std::vector<distance_type> weights(targets.size(), 1);
+    return make_csr_graph(std::move(offsets), std::move(targets), std::move(weights));
+}
+
+/**
+ * @return The vertex indices in the new order, i.e., <return>[i] is the original index of the new vertex i
+ */
+inline std::vector<vertex_type> compute_vertex_ordering(const CsrGraph &graph, VertexOrdering ordering) {
+    const auto number_vertices = static_cast<vertex_type>(graph.size());
+
+    std::vector<vertex_type> order{};
+    order.reserve(graph.size());
+
+    if (ordering == VertexOrdering::original) {
+        order.resize(graph.size());
+        std::iota(order.begin(), order.end(), vertex_type(0));
+        return order;
+    }
+
+    const auto undirected_graph = make_undirected_graph(graph, ordering == VertexOrdering::reverse_cuthill_mckee);
+    const auto degree = [&undirected_graph](vertex_type vertex_id) {
+        return out_degree(undirected_graph, vertex_id);
+    };
+
+    if (ordering == VertexOrdering::degree_descending) {
+        order.resize(graph.size());
+        std::iota(order.begin(), order.end(), vertex_type(0));
+        std::stable_sort(order.begin(), order.end(), [&degree](vertex_type lhs, vertex_type rhs) {
+            return degree(lhs) > degree(rhs);
+        });
+        return order;
+    }
+
+    std::vector<std::uint8_t> visited(graph.size(), 0);
+
+    if (ordering == VertexOrdering::bfs) {
+        for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+            if (visited[vertex_id] == 0) {
+                append_bfs_order(undirected_graph, vertex_id, visited, order);
+            }
+        }
+        return order;
+    }
+
+    // Cuthill-McKee starts every component at a pseudo-peripheral vertex (George and Liu): from a vertex of minimum degree,
+    // move to a vertex of minimum degree in the last BFS level as long as that makes the BFS deeper
+    std::vector<vertex_type> vertices_by_degree(graph.size());
+    std::iota(vertices_by_degree.begin(), vertices_by_degree.end(), vertex_type(0));
+    std::stable_sort(vertices_by_degree.begin(), vertices_by_degree.end(), [&degree](vertex_type lhs, vertex_type rhs) {
+        return degree(lhs) < degree(rhs);
+    });
+
+    std::vector<vertex_type> levels(graph.size(), -1);
+    std::vector<vertex_type> probe_order{};
+
+    // the depth of the BFS from start and a vertex of minimum degree in its last level
+    const auto probe = [&](vertex_type start_vertex_id) {
+        probe_order.assign(1, start_vertex_id);
+        levels[start_vertex_id] = 0;
+
+        for (std::size_t head = 0; head < probe_order.size(); head++) {
+            const auto vertex_id = probe_order[head];
+            for (const auto neighbor_id: undirected_graph.neighbors(vertex_id)) {
+                if (levels[neighbor_id] < 0) {
+                    levels[neighbor_id] = levels[vertex_id] + 1;
+                    probe_order.push_back(neighbor_id);
+                }
+            }
+        }
+
+        const auto depth = levels[probe_order.back()];
+        auto peripheral_vertex_id = probe_order.back();
+        for (auto position = probe_order.rbegin(); position != probe_order.rend() && levels[*position] == depth; ++position) {
+            if (degree(*position) < degree(peripheral_vertex_id)) {
+                peripheral_vertex_id = *position;
+            }
+        }
+
+        for (const auto vertex_id: probe_order) {
+            levels[vertex_id] = -1;
+        }
+
+        return std::make_pair(depth, peripheral_vertex_id);
+    };
+
+    for (const auto candidate_vertex_id: vertices_by_degree) {
+        if (visited[candidate_vertex_id] != 0) {
+            continue;
+        }
+
+        auto start_vertex_id = candidate_vertex_id;
+        auto [depth, peripheral_vertex_id] = probe(start_vertex_id);
+        for (int probe_id = 0; probe_id < 8 && peripheral_vertex_id != start_vertex_id; probe_id++) {
+            const auto [next_depth, next_peripheral_vertex_id] = probe(peripheral_vertex_id);
+            if (next_depth <= depth) {
+                break;
+            }
+            start_vertex_id = peripheral_vertex_id;
+            depth = next_depth;
+            peripheral_vertex_id = next_peripheral_vertex_id;
+        }
+
+        append_bfs_order(undirected_graph, start_vertex_id, visited, order);
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+/**
+ * @brief Relabels the graph in the given order, see compute_vertex_ordering
+ */
+inline ReorderedGraph reorder_graph(const CsrGraph &graph, VertexOrdering ordering) {
+    const PerfStageScope stage_scope(PerfStage::reordering);
+
+    const auto number_vertices = static_cast<vertex_type>(graph.size());
+    auto new_to_old = compute_vertex_ordering(graph, ordering);
+
+    std::vector<vertex_type> old_to_new(graph.size());
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        old_to_new[new_to_old[vertex_id]] = vertex_id;
+    }
+
+    std::vector<Edge> edges{};
+    edges.reserve(graph.number_edges());
+    for (vertex_type vertex_id = 0; vertex_id < number_vertices; vertex_id++) {
+        for_each_neighbor(graph, vertex_id, [&](vertex_type target_vertex_id, distance_type edge_weight) {
+            edges.push_back({old_to_new[vertex_id], old_to_new[target_vertex_id], edge_weight});
+        });
+    }
+
+    return {make_csr_graph(number_vertices, std::move(edges)), std::move(new_to_old), std::move(old_to_new)};
+}
+
+/**
+ * @return The mean of |i - j| over the edges i--->j, the smaller, the closer the distance entries that a search
+ *      touches together, a locality measure that needs no hardware counters
+ */
+inline double average_edge_span(const CsrGraph &graph) {
+    std::uint64_t span_sum = 0;
+    for (vertex_type vertex_id = 0; vertex_id < static_cast<vertex_type>(graph.size()); vertex_id++) {
+        for (const auto target_vertex_id: graph.neighbors(vertex_id)) {
+            span_sum += static_cast<std::uint64_t>(std::abs(target_vertex_id - vertex_id));
+        }
+    }
+    return graph.number_edges() == 0 ? 0.0 : static_cast<double>(span_sum) / static_cast<double>(graph.number_edges());
+}
+
+/**
+ * @brief Maps the distance matrix of a reordered graph back to the original vertex indices
+ */
+inline std::vector<distance_type> restore_distances(std::span<const distance_type> reordered_distances,
+                                                    const ReorderedGraph &reordered) {
+    const auto number_vertices = reordered.old_to_new.size();
+    std::vector<distance_type> all_distances(number_vertices * number_vertices);
+
+    std::vector<std::size_t> indices(number_vertices);
+    std::iota(indices.begin(), indices.end(), std::size_t(0));
+
+    parallel_for_each_source(indices, [&](vertex_type source_vertex_id) {
+        const auto *reordered_row = reordered_distances.data() + reordered.old_to_new[source_vertex_id] * number_vertices;
+        auto *row = all_distances.data() + source_vertex_id * number_vertices;
+
+        for (std::size_t target_vertex_id = 0; target_vertex_id < number_vertices; target_vertex_id++) {
+            row[target_vertex_id] = reordered_row[reordered.old_to_new[target_vertex_id]];
+        }
+    });
+
+    return all_distances;
+}
+
+/**
+ * @brief Maps the furthest reaching vertices of a reordered graph back to the original vertex indices
+ */
+inline std::vector<VertexDistancePair> restore_furthest_reaching_vertex(std::span<const VertexDistancePair> reordered_furthest,
+                                                                        const ReorderedGraph &reordered) {
+    std::vector<VertexDistancePair> furthest_reaching_vertex(reordered_furthest.size());
+
+    for (std::size_t vertex_id = 0; vertex_id < reordered_furthest.size(); vertex_id++) {
+        const auto &[reordered_vertex_id, distance] = reordered_furthest[reordered.old_to_new[vertex_id]];
+        furthest_reaching_vertex[vertex_id] = {reordered.new_to_old[reordered_vertex_id], distance};
+    }
+
+    return furthest_reaching_vertex;
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A fixed set of threads that run batches of independent tasks. The tasks of a batch are dealt round-robin
+ *      to per-worker queues in the given order, so if the tasks are sorted by decreasing cost, every worker starts
+ *      with its most expensive task. A worker takes tasks from the front of its own queue and, when it runs dry,
+ *      steals from the back of the other queues, i.e., the cheap tasks are used to even out the load at the end.
+ *      The calling thread takes part as worker 0, so a pool with one thread has no extra threads
+ */
+class WorkStealingPool {
+    struct WorkerQueue {
+        std::mutex mutex{};
+        std::deque<std::size_t> tasks{};
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues{};
+    std::vector<std::thread> threads{};
+
+    std::mutex mutex{};
+    std::condition_variable batch_started{};
+    std::condition_variable batch_finished{};
+
+    std::function<void(std::size_t, unsigned int)> current_function{};
+    std::size_t batch_generation = 0;
+    unsigned int running_workers = 0;
+    bool stopping = false;
+    // the first exception of the current batch, rethrown by run
+    std::exception_ptr batch_error{};
+
+    static bool &running_task() {
+        thread_local bool running = false;
+        return running;
+    }
+
+    struct RunningTaskScope {
+        RunningTaskScope() {
+            running_task() = true;
+        }
+
+        ~RunningTaskScope() {
+            running_task() = false;
+        }
+    };
+
+    std::optional<std::size_t> pop_own(unsigned int worker_id) {
+        auto &queue = *queues[worker_id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty()) {
+            return std::nullopt;
+        }
+
+        const auto task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return task;
+    }
+
+    std::optional<std::size_t> steal(unsigned int worker_id) {
+        const auto number_workers = static_cast<unsigned int>(queues.size());
+
+        for (unsigned int offset = 1; offset < number_workers; offset++) {
+            auto &queue = *queues[(worker_id + offset) % number_workers];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.tasks.empty()) {
+                const auto task = queue.tasks.back();
+                queue.tasks.pop_back();
+                return task;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    void work(unsigned int worker_id) {
+        // no tasks are added during a batch, so once all queues are empty, this worker is done
+        while (true) {
+            auto task = pop_own(worker_id);
+            if (!task) {
+                task = steal(worker_id);
+            }
+            if (!task) {
+                return;
+            }
+
+            // a failed task does not end the batch, the other tasks may wait for it (see run_together)
+            try {
+                const RunningTaskScope running_scope{};
+                current_function(*task, worker_id);
+            } catch (...) {
+                const std::lock_guard<std::mutex> lock(mutex);
+                if (!batch_error) {
+                    batch_error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void thread_loop(unsigned int worker_id) {
+        std::size_t seen_generation = 0;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                batch_started.wait(lock, [&] { return stopping || batch_generation != seen_generation; });
+
+                if (stopping) {
+                    return;
+                }
+                seen_generation = batch_generation;
+            }
+
+            work(worker_id);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running_workers--;
+            }
+            batch_finished.notify_one();
+        }
+    }
+
+public:
+    explicit WorkStealingPool(unsigned int number_threads) {
+        number_threads = std::max(number_threads, 1u);
+
+        for (unsigned int worker_id = 0; worker_id < number_threads; worker_id++) {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for (unsigned int worker_id = 1; worker_id < number_threads; worker_id++) {
+            threads.emplace_back(&WorkStealingPool::thread_loop, this, worker_id);
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        batch_started.notify_all();
+
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &other) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &other) = delete;
+
+    WorkStealingPool(WorkStealingPool &&other) = delete;
+    WorkStealingPool &operator=(WorkStealingPool &&other) = delete;
+
+    unsigned int number_threads() const {
+        return static_cast<unsigned int>(queues.size());
+    }
+
+    /**
+     * @return Whether the calling thread is running a task of any pool
+     */
+    static bool inside_task() {
+        return running_task();
+    }
+
+    /**
+     * @brief Runs function(task, worker_id) for every task and returns when all of them are done.
+     *      If tasks throw, the others still run and the first exception is rethrown once the batch is done.
+     *      Must not be called concurrently or from inside a task
+     * @param tasks The tasks, preferably sorted by decreasing cost
+     * @param function The function, worker_id is in [0, number_threads()) and unique among the concurrent calls
+     */
+    void run(std::span<const std::size_t> tasks, std::function<void(std::size_t, unsigned int)> function) {
+        const auto number_workers = number_threads();
+
+        for (std::size_t task_id = 0; task_id < tasks.size(); task_id++) {
+            auto &queue = *queues[task_id % number_workers];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(tasks[task_id]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current_function = std::move(function);
+            running_workers = number_workers - 1;
+            batch_generation++;
+        }
+        batch_started.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        batch_finished.wait(lock, [&] { return running_workers == 0; });
+        current_function = nullptr;
+
+        if (batch_error) {
+            const auto error = std::exchange(batch_error, nullptr);
+            lock.unlock();
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief Runs function(task) for the tasks 0, ..., number_tasks - 1 at the same time, each on its own worker, so the
+     *      tasks may wait for each other, e.g., at a std::barrier. A worker runs one task at a time and only leaves the
+     *      batch once all queues are empty, so while a task is not taken, some worker is free to take it.
+     *      Exceptions are rethrown like in run, so a task that throws must release the tasks waiting for it first.
+     *      Must not be called concurrently or from inside a task
+     * @param number_tasks The number of tasks, at most number_threads()
+     */
+    void run_together(std::size_t number_tasks, const std::function<void(std::size_t)> &function) {
+        if (number_tasks > number_threads()) {
+            throw std::invalid_argument("a pool with " + std::to_string(number_threads()) + " threads cannot run " +
+                                        std::to_string(number_tasks) + " tasks together");
+        }
+
+        std::vector<std::size_t> tasks(number_tasks);
+        std::iota(tasks.begin(), tasks.end(), std::size_t(0));
+
+        run(tasks, [&function](std::size_t task, unsigned int) {
+            function(task);
+        });
+    }
+};
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atomic_extrema.h"
+
+/*
+ * Contention microbenchmark of the argmax updates: every thread pushes the same number of random
+ * (distance, vertex) pairs into a few shared slots, which is what the parallel APSP reductions do per column.
+ * Fewer slots means more threads hitting the same cache line.
+ */
+
+constexpr std::size_t updates_per_thread = 1 << 20;
+
+std::vector<std::vector<std::uint64_t>> make_updates(unsigned int number_threads, std::uint32_t maximum_distance) {
+	std::vector<std::vector<std::uint64_t>> updates(number_threads);
+
+	for (unsigned int thread_id = 0; thread_id < number_threads; thread_id++) {
+		std::mt19937 generator(thread_id);
+		std::uniform_int_distribution<std::uint32_t> distance_distribution(0, maximum_distance);
+		std::uniform_int_distribution<std::uint32_t> vertex_distribution(0, 1 << 20);
+
+		updates[thread_id].resize(updates_per_thread);
+		for (auto& update : updates[thread_id]) {
+			update = pack_distance_vertex(distance_distribution(generator), vertex_distribution(generator));
+		}
+	}
+
+	return updates;
+}
+
+template <typename Function>
+void run_threads(unsigned int number_threads, Function&& function) {
+	std::vector<std::thread> threads{};
+	for (unsigned int thread_id = 1; thread_id < number_threads; thread_id++) {
+		threads.emplace_back(function, thread_id);
+	}
+	function(0);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+template <typename Update>
+std::uint64_t benchmark_packed(const std::string& name, const std::vector<std::vector<std::uint64_t>>& updates,
+	std::size_t number_slots, Update&& update) {
+	const auto number_threads = static_cast<unsigned int>(updates.size());
+	std::vector<std::atomic<std::uint64_t>> slots(number_slots);
+
+	const auto before = std::chrono::high_resolution_clock::now();
+	run_threads(number_threads, [&](unsigned int thread_id) {
+		const auto& thread_updates = updates[thread_id];
+		for (std::size_t update_id = 0; update_id < thread_updates.size(); update_id++) {
+			update(&slots[update_id % number_slots], thread_updates[update_id]);
+		}
+	});
+	const auto after = std::chrono::high_resolution_clock::now();
+
+	const auto nanoseconds = std::chrono::duration<double, std::nano>(after - before).count();
+	std::cout << "  " << name << ": " << nanoseconds / (number_threads * updates_per_thread) << " ns per update\n";
+
+	std::uint64_t result = 0;
+	for (const auto& slot : slots) {
+		result = std::max(result, slot.load());
+	}
+	return result;
+}
+
+std::uint64_t benchmark_wide(const std::vector<std::vector<std::uint64_t>>& updates, std::size_t number_slots) {
+	const auto number_threads = static_cast<unsigned int>(updates.size());
+	std::vector<WideDistanceVertex> slots(number_slots, WideDistanceVertex{0, ~std::uint64_t(0)});
+
+	const auto before = std::chrono::high_resolution_clock::now();
+	run_threads(number_threads, [&](unsigned int thread_id) {
+		const auto& thread_updates = updates[thread_id];
+		for (std::size_t update_id = 0; update_id < thread_updates.size(); update_id++) {
+			const auto packed = thread_updates[update_id];
+			atomic_fetch_argmax(&slots[update_id % number_slots], {packed_distance(packed), packed_vertex(packed)});
+		}
+	});
+	const auto after = std::chrono::high_resolution_clock::now();
+
+	const auto nanoseconds = std::chrono::duration<double, std::nano>(after - before).count();
+	std::cout << "  128-bit cmpxchg16b argmax: " << nanoseconds / (number_threads * updates_per_thread) << " ns per update\n";
+
+	auto result = slots.front();
+	for (const auto& slot : slots) {
+		if (wide_argmax_wins(slot, result)) {
+			result = slot;
+		}
+	}
+	return pack_distance_vertex(std::uint32_t(result.distance), std::uint32_t(result.vertex));
+}
+
+int main(int argc, char* argv[]) {
+	const auto number_threads = std::max(std::thread::hardware_concurrency(), 4u);
+
+	for (const std::uint32_t maximum_distance : {std::uint32_t(16), std::uint32_t(1) << 30}) {
+		const auto updates = make_updates(number_threads, maximum_distance);
+
+		for (const std::size_t number_slots : {std::size_t(1), std::size_t(64)}) {
+			std::cout << number_threads << " threads, " << number_slots << " slots, distances up to "
+				<< maximum_distance << ":\n";
+
+			const auto read_modify_write = benchmark_packed("read_modify_write", updates, number_slots,
+				[](std::atomic<std::uint64_t>* slot, std::uint64_t value) {
+					atomic_fetch_max_read_modify_write(slot, value, std::memory_order::relaxed);
+				});
+			const auto conditional_store = benchmark_packed("read_and_conditional_store", updates, number_slots,
+				[](std::atomic<std::uint64_t>* slot, std::uint64_t value) {
+					atomic_fetch_max_read_and_conditional_store(slot, value, std::memory_order::relaxed);
+				});
+			const auto fetch_argmax = benchmark_packed("64-bit packed atomic_fetch_argmax", updates, number_slots,
+				[](std::atomic<std::uint64_t>* slot, std::uint64_t value) {
+					atomic_fetch_argmax(slot, packed_distance(value), packed_vertex(value), std::memory_order::relaxed);
+				});
+			const auto wide_argmax = benchmark_wide(updates, number_slots);
+
+			if (read_modify_write != conditional_store || conditional_store != fetch_argmax || fetch_argmax != wide_argmax) {
+				std::cout << "  the strategies disagree on the maximum!\n";
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "atomic_min_max.h"
+
+/*
+ * fetch_max/fetch_min for integers and floats, and argmax updates of (distance, vertex) pairs.
+ * Unlike the CAS loops in atomic_min_max.h, all of them start with a relaxed load and return without writing
+ * when the stored value already wins, so under contention most updates never take the cache line exclusively.
+ * Otherwise fetch_max continues with atomic_fetch_max_read_and_conditional_store.
+ * Floats are compared with <, so a NaN is never stored and a stored NaN is never replaced.
+ */
+
+template <typename T>
+T atomic_fetch_max(std::atomic<T>* pv,
+	typename std::atomic<T>::value_type v,
+	std::memory_order m = std::memory_order::seq_cst) noexcept {
+	static_assert(std::is_arithmetic_v<T>);
+
+	const auto t = pv->load(std::memory_order::relaxed);
+	if (!(t < v))
+		return t;
+	return atomic_fetch_max_read_and_conditional_store(pv, v, m);
+}
+
+template <typename T>
+T atomic_fetch_min(std::atomic<T>* pv,
+	typename std::atomic<T>::value_type v,
+	std::memory_order m = std::memory_order::seq_cst) noexcept {
+	static_assert(std::is_arithmetic_v<T>);
+
+	auto t = pv->load(std::memory_order::relaxed);
+	while (v < t) {
+		if (pv->compare_exchange_weak(t, v, m, std::memory_order::relaxed))
+			break;
+	}
+	return t;
+}
+
+/*
+ * A 32-bit distance and a 32-bit vertex packed into one 64-bit word as (distance << 32) | ~vertex,
+ * so the largest word has the largest distance and, among equal distances, the smallest vertex.
+ * An argmax is therefore a plain fetch_max on one lock-free 64-bit atomic, and its result does not depend
+ * on the order of the updates.
+ */
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the packed argmax needs lock-free 64-bit atomics");
+
+inline std::uint64_t pack_distance_vertex(std::uint32_t distance, std::uint32_t vertex) noexcept {
+	return (std::uint64_t(distance) << 32) | std::uint32_t(~vertex);
+}
+
+inline std::uint32_t packed_distance(std::uint64_t packed) noexcept {
+	return std::uint32_t(packed >> 32);
+}
+
+inline std::uint32_t packed_vertex(std::uint64_t packed) noexcept {
+	return ~std::uint32_t(packed);
+}
+
+/**
+ * @brief Replaces the stored pair by (distance, vertex) if the distance is larger, or equal and the vertex smaller
+ * @return The previously stored packed pair
+ */
+inline std::uint64_t atomic_fetch_argmax(std::atomic<std::uint64_t>* pv,
+	std::uint32_t distance, std::uint32_t vertex,
+	std::memory_order m = std::memory_order::seq_cst) noexcept {
+	return atomic_fetch_max(pv, pack_distance_vertex(distance, vertex), m);
+}
+
+/*
+ * The same argmax for pairs that do not fit into 64 bits, e.g., 64-bit distances or vertices.
+ * On x86-64, the 16-byte pair is updated with lock cmpxchg16b. std::atomic of 16 bytes would go through libatomic,
+ * which is not guaranteed to be lock-free. Elsewhere it falls back to std::atomic_ref.
+ */
+
+struct alignas(16) WideDistanceVertex {
+	std::uint64_t distance;
+	std::uint64_t vertex;
+};
+
+inline bool wide_argmax_wins(const WideDistanceVertex& lhs, const WideDistanceVertex& rhs) noexcept {
+	return lhs.distance > rhs.distance || (lhs.distance == rhs.distance && lhs.vertex < rhs.vertex);
+}
+
+#if defined(__x86_64__)
+
+/**
+ * @brief Stores desired if *pv equals expected, otherwise loads *pv into expected (atomically, with full ordering)
+ */
+inline bool compare_exchange_16_bytes(WideDistanceVertex* pv,
+	WideDistanceVertex& expected, const WideDistanceVertex& desired) noexcept {
+	bool exchanged;
+	asm volatile("lock cmpxchg16b %1"
+		: "=@ccz"(exchanged), "+m"(*pv), "+a"(expected.distance), "+d"(expected.vertex)
+		: "b"(desired.distance), "c"(desired.vertex)
+		: "memory");
+	return exchanged;
+}
+
+/**
+ * @brief Replaces *pv by (distance, vertex) if the distance is larger, or equal and the vertex smaller
+ * @return The previously stored pair
+ */
+inline WideDistanceVertex atomic_fetch_argmax(WideDistanceVertex* pv, const WideDistanceVertex& v) noexcept {
+	// the halves are only a first guess, they may be torn. The result is always confirmed by cmpxchg16b: if v loses,
+	// the stored pair is "replaced" by itself, and if that fails, t receives the whole pair atomically and is checked again
+	WideDistanceVertex t;
+	t.distance = std::atomic_ref<std::uint64_t>(pv->distance).load(std::memory_order::relaxed);
+	t.vertex = std::atomic_ref<std::uint64_t>(pv->vertex).load(std::memory_order::relaxed);
+
+	while (true) {
+		const auto desired = wide_argmax_wins(v, t) ? v : t;
+		if (compare_exchange_16_bytes(pv, t, desired))
+			break;
+	}
+	return t;
+}
+
+#else
+
+inline WideDistanceVertex atomic_fetch_argmax(WideDistanceVertex* pv, const WideDistanceVertex& v) noexcept {
+	std::atomic_ref<WideDistanceVertex> atomic_view(*pv);
+
+	auto t = atomic_view.load(std::memory_order::relaxed);
+	while (wide_argmax_wins(v, t)) {
+		if (atomic_view.compare_exchange_weak(t, v))
+			break;
+	}
+	return t;
+}
+
+#endif